@@ -14,6 +14,18 @@
  * This example shows characters from the serial port on the M5StickC display.
  * If a Keyboard-Hat is connected, also the characters from the Keyboard
  * are shown on the display.
+ * Button B scrolls one page back into the history, a long press of
+ * Button B shows a text demo. Button A scrolls one page forward or
+ * changes the orientation of the display if the actual rows are shown.
+ * The up and down keys of the Keyboard-Hat scroll one page as well.
+ * The characters are pushed into a queue and drawn by a render task
+ * on the other core, so the loop never waits for the display.
+ * Ctrl-T on the serial port or the Tab key of the Keyboard-Hat prints
+ * the statistics of the display over the serial port.
+ * Ctrl-B on the serial port runs the benchmark of the display and
+ * prints the results.
+ * Ctrl-D on the serial port sends the M5StickC into the deep sleep for
+ * 10 seconds. After the wake up, the display shows the same rows again.
  * 
  * Changelog:
  * v1.0 = - initial version
@@ -27,6 +39,65 @@
  *        - screen_xpos and text_buffer_write_pointer_x set in display_show function
  * v1.5 = - Bugfix if the character that causes a word wrap is a space character
  * v1.6 = Added case differentiation between M5StcikC und M5StickCPlus
+ * v1.7 = - Drawing through exchangeable display backends
+ *          (M5StickC, M5StickCPlus and RGB565 framebuffer)
+ * v1.8 = - Optional hardware scroll of the LCD controller for a new line
+ * v1.9 = - Only changed rows and characters are redrawn
+ * v1.10 = - Optional row sprite mode: characters are drawn off-screen
+ *           and pushed with one transfer
+ * v1.11 = - tb_display_print_String draws the screen only once
+ * v1.12 = - Line wrap and Word-Wrap are calculated with the character
+ *           widths before anything is drawn
+ * v1.13 = - Scrollback history with page up and page down
+ *         - Example: Button B = page up, Button A = page down
+ *           (or change orientation if the actual rows are shown)
+ *           Text demo with a long press of Button B
+ * v1.14 = - Lock-free input queue and render task on the second core
+ *         - Example: serial and keyboard characters are queued
+ * v1.15 = - Typewriter effect without delay() driven by a millis() tick
+ *         - Example: the text demo does not stop the loop anymore
+ * v1.16 = - Optional limited frame rate: changes are drawn by tb_display_update()
+ *         - Example: 25 frames per second
+ * v1.17 = - The state of the text buffer is kept in a viewport
+ *         - Several scrolling viewports can share the screen (TB_TextBuffer)
+ *         - Landscape and portrait mode share the text buffer memory
+ * v1.18 = - ANSI/VT100 escape sequences for the cursor position, erasing
+ *           and colors (per character)
+ * v1.19 = - Glyph cache: the characters are rendered once per color and
+ *           copied to the screen
+ * v1.20 = - Counters and timing histograms of the drawing
+ *         - Example: Ctrl-T or Tab prints the statistics
+ * v1.21 = - tb_display_print_bytes and tb_display_queue_push_bytes for
+ *           blocks of received bytes
+ *         - Example: the serial characters are read, queued and echoed
+ *           in blocks
+ * v1.22 = - Keyboard-Hat polling with an interval that adapts to the typing
+ *         - Example: the Keyboard-Hat is not read in every loop
+ * v1.23 = - Line editor with a cursor, insert and delete inside the line
+ *         - Only the changed part of a row is drawn again
+ *         - Example: the Keyboard-Hat input is edited with the left and
+ *           right keys and sent to the serial port with Enter
+ * v1.24 = - tb_display_set_rotation keeps the text: the logical lines are
+ *           wrapped again for the new rotation
+ *         - Example: Button A changes the orientation without clearing
+ *           the display
+ * v1.25 = - UTF-8 text: Latin-1 characters and symbols with an extended
+ *           font (tb_display_charset.h)
+ * v1.26 = - Benchmark with a counting LCD stub and golden frames
+ *           (tb_display_bench.h)
+ *         - Example: Ctrl-B runs the benchmark
+ * v1.27 = - Mirror of the display over the serial port: only the changed
+ *           rows are sent (tb_display_mirror.h, tb_mirror_view.cpp)
+ *         - Example: Ctrl-E starts and stops the mirror
+ * v1.28 = - Pinned status fields above the scrolling text: only the
+ *           changed characters of a field are drawn
+ *         - Example: the uptime and the received bytes in a status row
+ * v1.29 = - Arduino Print interface: TBDisplay.print(), println() and
+ *           printf() (tb_display_print.h)
+ *         - Example: the benchmark result is shown on the display
+ * v1.30 = - Snapshot of the screen rows in the RTC memory: the display
+ *           is restored after the deep sleep (tb_display_snapshot.h)
+ *         - Example: Ctrl-D sends the M5StickC into the deep sleep
  * 
  * M5StickC screen resolution:       80*160
  * M5StickC-plus screen resolution: 135*240
@@ -46,9 +117,34 @@
 //#include <M5StickC.h>
 
 #include "tb_display.h"
+#include "tb_display_config.h"
+#include "tb_display_queue.h"
+#include "tb_display_typewriter.h"
+#include "tb_display_stats.h"
+#include "tb_display_glyph_cache.h"
+#include "tb_display_keyboard.h"
+#include "tb_display_bench.h"
+#include "tb_display_mirror.h"
+#include "tb_display_print.h"
+#include "tb_display_snapshot.h"
 
-// I2C Adress of the Keyboard Hat
-#define CARDKB_ADDR 0x5F
+// key to print the statistics: Ctrl-T on the serial port
+#define STATS_KEY 0x14
+// key to run the benchmark: Ctrl-B on the serial port
+#define BENCH_KEY 0x02
+// key to start and stop the mirror: Ctrl-E on the serial port
+#define MIRROR_KEY 0x05
+// the changes of the display are sent every 100ms
+#define MIRROR_INTERVAL 100
+// key to start the deep sleep: Ctrl-D on the serial port
+#define SLEEP_KEY 0x04
+// time in the deep sleep (in microseconds)
+#define SLEEP_TIME_US 10000000ULL
+// the status fields are updated every 20ms (50 times per second)
+#define STATUS_INTERVAL 20
+
+// characters read from the serial port at once
+#define SERIAL_CHUNK 256
 
 // Display brightness level
 // possible values: 7 - 15
@@ -61,6 +157,134 @@ uint8_t screen_brightness = 15;
 // 4 = Button below
 int screen_orientation = 3;
 
+// the mirror of the display sends frames over the serial port
+bool mirror_active = false;
+unsigned long mirror_time = 0;
+
+// the values of the status fields
+unsigned long status_time = 0;
+uint32_t serial_bytes = 0;
+
+
+// =============================================================
+// print a histogram of times over the serial port
+// =============================================================
+void print_histogram(const char *name, const tb_display_histogram *h){
+  char String_buffer[128];
+  snprintf(String_buffer, sizeof(String_buffer), "%s: n=%u min=%uus avg=%uus max=%uus",
+           name, h->count, h->min, tb_display_stats_average(h), h->max);
+  Serial.println(String_buffer);
+  // only the buckets with values
+  for(int n=0; n<TB_DISPLAY_STATS_BUCKETS; n++){
+    if(h->buckets[n] == 0)
+      continue;
+    snprintf(String_buffer, sizeof(String_buffer), "  %6lu-%6lu us: %u",
+             n == 0 ? 0UL : 1UL << n,
+             n == TB_DISPLAY_STATS_BUCKETS-1 ? (unsigned long)h->max : (2UL << n) - 1,
+             h->buckets[n]);
+    Serial.println(String_buffer);
+  }
+}
+
+// =============================================================
+// print the statistics of the display over the serial port
+// =============================================================
+void print_display_stats(){
+  // copy the values, the render task changes them
+  tb_display_lock();
+  tb_display_statistics stats = *tb_display_stats();
+  uint32_t cache_hits = tb_display_glyph_cache_hits();
+  uint32_t cache_misses = tb_display_glyph_cache_misses();
+  uint32_t cache_bytes = tb_display_glyph_cache_bytes();
+  tb_display_unlock();
+  char String_buffer[128];
+  Serial.println("\n===================");
+  snprintf(String_buffer, sizeof(String_buffer), "drawChar: %u  pixels: %llu (%llu bytes)",
+           stats.draw_chars, (unsigned long long)stats.pixels, (unsigned long long)stats.pixels*2);
+  Serial.println(String_buffer);
+  snprintf(String_buffer, sizeof(String_buffer), "refresh: %u full, %u partial",
+           stats.full_refreshes, stats.partial_refreshes);
+  Serial.println(String_buffer);
+  snprintf(String_buffer, sizeof(String_buffer), "word wrap: %u words, %u characters moved",
+           stats.wrap_backtracks, stats.wrap_moved);
+  Serial.println(String_buffer);
+  snprintf(String_buffer, sizeof(String_buffer), "glyph cache: %u hits, %u misses, %u bytes",
+           cache_hits, cache_misses, cache_bytes);
+  Serial.println(String_buffer);
+  snprintf(String_buffer, sizeof(String_buffer), "queue: max %u, %u dropped",
+           tb_display_queue_max_fill(), tb_display_queue_dropped());
+  Serial.println(String_buffer);
+  print_histogram("show", &stats.show_time);
+  print_histogram("refresh", &stats.refresh_time);
+  print_histogram("char", &stats.char_time);
+  Serial.println("===================");
+}
+
+// =============================================================
+// the frames of a workload compared with the golden frames
+// =============================================================
+const char *bench_frames(const tb_display_bench_result *result){
+  if(!result->frames_taken)
+    return "NO FRAMEBUFFER";
+  if(result->middle_crc != result->golden_middle_crc)
+    return "middle DIFFERS";
+  if(result->frame_crc != result->golden_crc)
+    return "last DIFFERS";
+  return "ok";
+}
+
+// =============================================================
+// run the benchmark and print the results over the serial port
+// The display is cleared.
+// =============================================================
+void run_display_bench(){
+  tb_display_bench_result results[TB_DISPLAY_BENCH_WORKLOADS];
+  // the render task must not draw in the meantime
+  tb_display_lock();
+  bool frames_ok = tb_display_bench_run(results, screen_orientation);
+  tb_display_set_frame_rate(25);
+  // the display was cleared: show the result there as well
+  TBDisplay.printf("benchmark: %s\n", frames_ok ? "ok" : "frames differ");
+  for(int n=0; n<TB_DISPLAY_BENCH_WORKLOADS; n++)
+    TBDisplay.printf("%s: %u/s\n", results[n].name, results[n].chars_per_second);
+  tb_display_unlock();
+  char String_buffer[128];
+  Serial.println("\n===================");
+  for(int n=0; n<TB_DISPLAY_BENCH_WORKLOADS; n++){
+    snprintf(String_buffer, sizeof(String_buffer), "%s: %u chars/s, %u bytes/char, frames %s",
+             results[n].name, results[n].chars_per_second,
+             results[n].lcd_bytes / results[n].chars, bench_frames(&results[n]));
+    Serial.println(String_buffer);
+  }
+  Serial.println(frames_ok ? "benchmark: all frames ok" : "benchmark: FRAMES DIFFER");
+  Serial.println("===================");
+}
+
+// =============================================================
+// keep the display in the RTC memory and start the deep sleep
+// The M5StickC wakes up after SLEEP_TIME_US and starts
+// with setup() again.
+// =============================================================
+void start_deep_sleep(){
+  // the queued characters are printed first
+  tb_display_render_task_end();
+  tb_display_queue_process();
+  if(tb_display_snapshot_save())
+    Serial.println("\ndeep sleep");
+  else
+    Serial.println("\ndeep sleep: the display does not fit into the RTC memory");
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup(SLEEP_TIME_US);
+  esp_deep_sleep_start();
+}
+
+// =============================================================
+// send the frames of the mirror over the serial port
+// =============================================================
+size_t mirror_write(const uint8_t *data, size_t length){
+  return Serial.write(data, length);
+}
+
 
 void setup() {
   // initialize the M5Stack object
@@ -69,6 +293,9 @@ void setup() {
   Wire.begin(0, 26);
   // Grove-Connector: Pin 32 and 33
   //Wire.begin(32, 33);
+  // the Keyboard Hat is read only every 10ms while typing
+  // and every 160ms if nobody is typing
+  tb_display_keyboard_begin(tb_display_keyboard_cardkb);
   // set screen brightness
   //M5.Axp.ScreenBreath(screen_brightness);
   M5.Lcd.setTextColor(TFT_WHITE);  
@@ -77,76 +304,158 @@ void setup() {
 	Serial.println("===================");
 	Serial.println("     M5StickC");
 	Serial.println("Textbuffer Display");
-	Serial.println(" 29.07.2024 v1.6");
+	Serial.println(" 17.10.2026 v1.30");
 	Serial.println("===================");
 
   // init the text buffer display and print welcome text on the display
+  // The top row shows the status fields, the text scrolls below.
+  // After the deep sleep, the rows of the snapshot are shown again.
+  bool wake_up = tb_display_snapshot_valid();
+  tb_display_status_rows = 1;
   tb_display_init(screen_orientation);
-  tb_display_print_String("M5StickC\n\nTextbuffer Display\n\n");
+  // the uptime fits to the portrait mode as well,
+  // the received bytes are only shown in landscape mode
+  tb_display_status_field(0, 0, 0, SCREEN_HEIGHT);
+  tb_display_status_field(1, 0, SCREEN_HEIGHT, SCREEN_WIDTH-SCREEN_HEIGHT);
+  tb_display_status_color(1, 0x0B);
+  if(wake_up)
+    tb_display_print_String("\nwake up\n");
+  else
+    tb_display_print_String("M5StickC\n\nTextbuffer Display\n\n");
+  // not more than 25 frames per second: a flood of short lines
+  // from the serial port is drawn with one frame every 40ms
+  tb_display_set_frame_rate(25);
+  // the characters from the serial port and the keyboard are
+  // drawn by the render task on the other core
+  tb_display_render_task_begin();
 }
 
 
 void loop() {
   M5.update();
 
-  // change the display orientation if Button A is pressed
-  if (M5.BtnA.wasPressed()){
+  // the render task uses the display as well
+  tb_display_lock();
+  // scroll one page forward in the history if Button A is pressed
+  // or change the display orientation if the actual rows are shown
+  if (M5.BtnA.wasPressed() && tb_display_scroll_position() > 0){
+    tb_display_page_down();
+  } else if (M5.BtnA.wasPressed()){
     screen_orientation++;
     if(screen_orientation > 4)
       screen_orientation = 1;
-    // init the text buffer display with the new orientation
-    tb_display_init(screen_orientation);
-    // different text alignment for landscape or portrait mode
-    switch (screen_orientation) {
-      case 1: case 3: {
-        tb_display_print_String("        M5StickC\n\n   Textbuffer Display\n\n");
-        break;
-      }
-      case 2: case 4: {
-        tb_display_print_String(" M5StickC\n\nTextbuffer\n  Display\n\n\n\n\n");
-        break;
-      }
-      default: {
-        break;
-      }
-    }
+    // the text stays on the display and is wrapped again
+    // for the new orientation
+    tb_display_set_rotation(screen_orientation);
   }
 
-  // Display a long Text if Button B is pressed
-  if (M5.BtnB.wasPressed()){
+  // scroll one page back in the history if Button B is pressed
+  // Display a long Text if Button B is pressed for 1 second
+  if (M5.BtnB.wasReleasefor(1000)){
     // note:
     // with 85ms Character delay, the display looks more
     // like Teletype or a typewriter
-    tb_display_print_String("The quick brown fox jumps over the lazy dog and was surprised that he used all letters of the alphabet.", 85);
+    // The characters are typed by tb_display_typewriter_tick(),
+    // so the loop continues in the meantime
+    tb_display_type_String("The quick brown fox jumps over the lazy dog and was surprised that he used all letters of the alphabet.", 85);
+  } else if (M5.BtnB.wasReleased()){
+    tb_display_page_up();
   }
+  // type the next character of the text demo
+  tb_display_typewriter_tick();
+  tb_display_unlock();
 
   // check for serial input and print the received characters
+  // All available characters are read, queued and echoed at once.
+  // (the characters are queued, the render task prints them)
   while(Serial.available() > 0){
-    char data = Serial.read();
-    tb_display_print_char(data);
-    Serial.write(data);
+    uint8_t Serial_buffer[SERIAL_CHUNK];
+    int length = Serial.available();
+    if(length > SERIAL_CHUNK)
+      length = SERIAL_CHUNK;
+    length = Serial.readBytes(Serial_buffer, length);
+    serial_bytes += length;
+    // the statistics and benchmark keys are not shown
+    bool print_stats = false;
+    bool run_bench = false;
+    bool toggle_mirror = false;
+    bool deep_sleep = false;
+    int count = 0;
+    for(int n = 0; n < length; n++){
+      if(Serial_buffer[n] == STATS_KEY)
+        print_stats = true;
+      else if(Serial_buffer[n] == BENCH_KEY)
+        run_bench = true;
+      else if(Serial_buffer[n] == MIRROR_KEY)
+        toggle_mirror = true;
+      else if(Serial_buffer[n] == SLEEP_KEY)
+        deep_sleep = true;
+      else
+        Serial_buffer[count++] = Serial_buffer[n];
+    }
+    tb_display_queue_push_bytes(Serial_buffer, count);
+    Serial.write(Serial_buffer, count);
+    if(print_stats)
+      print_display_stats();
+    if(run_bench)
+      run_display_bench();
+    if(toggle_mirror){
+      mirror_active = !mirror_active;
+      if(mirror_active)
+        tb_display_mirror_begin(mirror_write);
+      else
+        tb_display_mirror_end();
+    }
+    if(deep_sleep)
+      start_deep_sleep();
+  }
+
+  // update the status fields (only the changed characters are drawn)
+  if(millis() - status_time >= STATUS_INTERVAL){
+    status_time = millis();
+    char status[TB_DISPLAY_STATUS_LENGTH];
+    tb_display_lock();
+    snprintf(status, sizeof(status), "%lu.%02lus", status_time/1000, (status_time/10)%100);
+    tb_display_status_set(0, status);
+    snprintf(status, sizeof(status), "rx %u", serial_bytes);
+    tb_display_status_set(1, status);
+    tb_display_unlock();
+  }
+
+  // send the changes of the display to the mirror
+  // (tb_mirror_view.cpp shows them on a Linux host)
+  if(mirror_active && millis() - mirror_time >= MIRROR_INTERVAL){
+    mirror_time = millis();
+    tb_display_lock();
+    tb_display_mirror_update();
+    tb_display_unlock();
   }
 
   
-  // check for input from the Keyboard Hat and print the received characters
-  Wire.requestFrom(CARDKB_ADDR, 1);
-  while (Wire.available())
+  // check for input from the Keyboard Hat and edit a line
+  // (the keyboard is read only if the poll interval is over)
+  // The completed line is sent to the serial port with Enter.
+  tb_display_keyboard_poll();
+  int key;
+  while ((key = tb_display_keyboard_read()) >= 0)
   {
-    char c = Wire.read(); // receive a byte as characterif
-    if (c != 0)
-    {
-      if (c == 13) { //0x0D = CR = '\r'
-        // Map CR to LF (0x0A)
-        tb_display_print_char('\n');
-        Serial.write('\n');
-      } else {
-        if(c == 8){ // del on the Keyboard
-          tb_display_delete_char();
-        } else {
-          tb_display_print_char(c);
-          Serial.write(c);
-        }
-      }
+    if(key == 0xB5){ // up key on the Keyboard
+      tb_display_lock();
+      tb_display_page_up();
+      tb_display_unlock();
+    } else if(key == 0xB6){ // down key on the Keyboard
+      tb_display_lock();
+      tb_display_page_down();
+      tb_display_unlock();
+    } else if(key == '\t'){ // Tab key on the Keyboard
+      print_display_stats();
+    } else if(key != 0){
+      // characters, del, left, right and Enter edit the line
+      tb_display_lock();
+      bool completed = tb_display_edit_key(key);
+      tb_display_unlock();
+      if(completed)
+        Serial.println(tb_display_edit_line());
     }
   }
 }
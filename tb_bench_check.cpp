@@ -0,0 +1,152 @@
+/******************************************************************************
+ * tb_bench_check.cpp
+ * Linux host check of the benchmark of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Runs the workloads of tb_display_bench_run() on a Linux host,
+ * compares the frames (in the middle and at the end of each workload)
+ * with the golden frames and the speed and the LCD bytes with a
+ * baseline (tb_display_bench_compare). The exit code is 1 if a frame
+ * differs or is missing (no memory for the framebuffer) or a workload
+ * is slower or sends more bytes than the tolerance allows, so the
+ * check can run in a build script.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_bench_check.cpp -o tb_bench_check -lpthread
+ *    ./tb_bench_check
+ * (with -D M5STICKC for the M5StickC, default is the M5StickCPlus)
+ * options:
+ *    -t percent   tolerance (default 20)
+ *    -s file      save the results as baseline
+ *    -b file      compare with a saved baseline instead of the
+ *                 baseline of this file
+ * The LCD bytes are the same on every host, the speed is not. The
+ * speed of the baseline below is about 60% of -O2 runs on an x86-64
+ * server, so only a clear regression fails on a busy host. On a slower
+ * machine, save a baseline once with -s and compare with -b afterwards.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tb_display_host.h"
+#include "tb_display.h"
+#include "tb_display_config.h"
+#include "tb_display_bench.h"
+
+// the workloads run several times, the fastest run counts
+#define BENCH_CHECK_RUNS 5
+// default tolerance in percent
+#define BENCH_CHECK_TOLERANCE 20
+
+// chars_per_second and lcd_bytes of each workload (landscape mode)
+#ifdef M5STICKC
+static tb_display_bench_result bench_baseline[TB_DISPLAY_BENCH_WORKLOADS] = {
+  {"log lines",   0, 0, 5000000,  3180755, 0, 0, 0, 0, 0, false},
+  {"long tokens", 0, 0, 4000000, 11249039, 0, 0, 0, 0, 0, false},
+  {"word wrap",   0, 0, 3600000, 14525692, 0, 0, 0, 0, 0, false},
+  {"backspace",   0, 0, 4500000,  4940945, 0, 0, 0, 0, 0, false}
+};
+#endif
+#ifdef M5STICKCPLUS
+static tb_display_bench_result bench_baseline[TB_DISPLAY_BENCH_WORKLOADS] = {
+  {"log lines",   0, 0, 3000000, 12072971, 0, 0, 0, 0, 0, false},
+  {"long tokens", 0, 0, 3000000, 17831109, 0, 0, 0, 0, 0, false},
+  {"word wrap",   0, 0, 2800000, 23607603, 0, 0, 0, 0, 0, false},
+  {"backspace",   0, 0, 3300000,  7935548, 0, 0, 0, 0, 0, false}
+};
+#endif
+
+// =============================================================
+// read a baseline saved with -s
+// one line per workload: chars_per_second lcd_bytes name
+// =============================================================
+static bool bench_check_load(const char *file_name, tb_display_bench_result *baseline){
+  FILE *file = fopen(file_name, "r");
+  if(file == NULL)
+    return false;
+  int n = 0;
+  while(n < TB_DISPLAY_BENCH_WORKLOADS &&
+        fscanf(file, "%u %u %*[^\n]", &baseline[n].chars_per_second, &baseline[n].lcd_bytes) == 2)
+    n++;
+  fclose(file);
+  return n == TB_DISPLAY_BENCH_WORKLOADS;
+}
+
+// =============================================================
+// save the results as baseline
+// =============================================================
+static bool bench_check_save(const char *file_name, const tb_display_bench_result *results){
+  FILE *file = fopen(file_name, "w");
+  if(file == NULL)
+    return false;
+  for(int n = 0; n < TB_DISPLAY_BENCH_WORKLOADS; n++)
+    fprintf(file, "%u %u %s\n", results[n].chars_per_second, results[n].lcd_bytes, results[n].name);
+  return fclose(file) == 0;
+}
+
+// =============================================================
+// the frames of a workload compared with the golden frames
+// =============================================================
+static const char *bench_check_frames(const tb_display_bench_result *result){
+  if(!result->frames_taken)
+    return "NO FRAMEBUFFER";
+  if(result->middle_crc != result->golden_middle_crc)
+    return "middle DIFFERS";
+  if(result->frame_crc != result->golden_crc)
+    return "last DIFFERS";
+  return "ok";
+}
+
+int main(int argc, char *argv[]){
+  int tolerance = BENCH_CHECK_TOLERANCE;
+  const char *save_file = NULL;
+  const char *baseline_file = NULL;
+  for(int n = 1; n < argc; n++){
+    if(strcmp(argv[n], "-t") == 0 && n+1 < argc)
+      tolerance = atoi(argv[++n]);
+    else if(strcmp(argv[n], "-s") == 0 && n+1 < argc)
+      save_file = argv[++n];
+    else if(strcmp(argv[n], "-b") == 0 && n+1 < argc)
+      baseline_file = argv[++n];
+    else {
+      fprintf(stderr, "usage: %s [-t percent] [-s file] [-b file]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(baseline_file != NULL && !bench_check_load(baseline_file, bench_baseline)){
+    fprintf(stderr, "%s: no baseline\n", baseline_file);
+    return 2;
+  }
+
+  tb_display_init(1);
+  tb_display_bench_result results[TB_DISPLAY_BENCH_WORKLOADS];
+  tb_display_bench_result run[TB_DISPLAY_BENCH_WORKLOADS];
+  bool frames_ok = true;
+  for(int r = 0; r < BENCH_CHECK_RUNS; r++){
+    if(!tb_display_bench_run(run, 1))
+      frames_ok = false;
+    for(int n = 0; n < TB_DISPLAY_BENCH_WORKLOADS; n++)
+      if(r == 0 || run[n].chars_per_second > results[n].chars_per_second)
+        results[n] = run[n];
+  }
+
+  bool speed_ok = tb_display_bench_compare(results, bench_baseline, tolerance);
+  for(int n = 0; n < TB_DISPLAY_BENCH_WORKLOADS; n++){
+    printf("%-12s %9u chars/s (baseline %9u)  %9u LCD bytes (baseline %9u)  frames %s\n",
+           results[n].name, results[n].chars_per_second, bench_baseline[n].chars_per_second,
+           results[n].lcd_bytes, bench_baseline[n].lcd_bytes, bench_check_frames(&results[n]));
+  }
+  if(save_file != NULL && !bench_check_save(save_file, results)){
+    fprintf(stderr, "%s: not saved\n", save_file);
+    return 2;
+  }
+  printf("frames: %s\n", frames_ok ? "ok" : "DIFFER");
+  printf("speed and LCD bytes (tolerance %d%%): %s\n", tolerance, speed_ok ? "ok" : "REGRESSION");
+  return frames_ok && speed_ok ? 0 : 1;
+}
+
+#endif // TB_DISPLAY_HOST
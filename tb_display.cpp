@@ -2,7 +2,7 @@
  * tb_display.cpp
  * Library for a simple text buffer scrolling display on the M5StickC.
  * Hague Nusseck @ electricidea
- * v1.6 29.July.2024
+ * v1.30 17.Oct.2026
  * https://github.com/electricidea/M5StickC-TB_Display
  * 
  * This library makes it easy to display texts on the M5StickC.
@@ -22,179 +22,1354 @@
  *        - screen_xpos and text_buffer_write_pointer_x set in display_show function
  * v1.5 = - Bugfix if the character that causes a word wrap is a space character
  * v1.6 = Added case differentiation between M5StcikC und M5StickCPlus
+ * v1.7 = - Drawing through exchangeable display backends
+ *          (M5StickC, M5StickCPlus and RGB565 framebuffer)
+ * v1.8 = - Optional hardware scroll of the LCD controller for a new line
+ * v1.9 = - Only changed rows and characters are redrawn
+ * v1.10 = - Optional row sprite mode: characters are drawn off-screen
+ *           and pushed with one transfer
+ * v1.11 = - tb_display_print_String draws the screen only once
+ * v1.12 = - Line wrap and Word-Wrap are calculated with the character
+ *           widths before anything is drawn
+ * v1.13 = - Scrollback history with page up and page down
+ * v1.14 = - Lock-free input queue and render task on the second core
+ * v1.15 = - Typewriter effect without delay() driven by a millis() tick
+ * v1.16 = - Optional limited frame rate: changes are drawn by tb_display_update()
+ * v1.17 = - The state of the text buffer is kept in a viewport
+ *         - Several scrolling viewports can share the screen (TB_TextBuffer)
+ *         - Landscape and portrait mode share the text buffer memory
+ * v1.18 = - ANSI/VT100 escape sequences for the cursor position, erasing
+ *           and colors (per character)
+ * v1.19 = - Glyph cache: the characters are rendered once per color and
+ *           copied to the screen
+ * v1.20 = - Counters and timing histograms of the drawing (tb_display_stats.h)
+ * v1.21 = - tb_display_print_bytes for blocks of received bytes
+ * v1.22 = - Keyboard-Hat polling with an interval that adapts to the typing
+ *           (tb_display_keyboard.h)
+ * v1.23 = - Line editor with a cursor, insert and delete inside the line
+ *         - Only the changed part of a row is drawn again
+ * v1.24 = - tb_display_set_rotation keeps the text: the logical lines are
+ *           wrapped again for the new rotation
+ * v1.25 = - UTF-8 text: Latin-1 characters and symbols with an extended
+ *           font (tb_display_charset.h)
+ * v1.26 = - Benchmark with a counting LCD stub and golden frames
+ *           (tb_display_bench.h)
+ * v1.27 = - Mirror of the display over the serial port: only the changed
+ *           rows are sent (tb_display_mirror.h)
+ * v1.28 = - Pinned status fields above the scrolling text: only the
+ *           changed characters of a field are drawn
+ * v1.29 = - Arduino Print interface: TBDisplay.print(), println() and
+ *           printf() (tb_display_print.h)
+ *         - tb_display_batch_begin/end: several prints are drawn once
+ * v1.30 = - Snapshot of the screen rows in the RTC memory: tb_display_init
+ *           restores the display after the deep sleep (tb_display_snapshot.h)
+ *         - tb_display_set_backend sets the default colors of the new backend
  * 
  * 
  * Distributed as-is; no warranty is given.
  ******************************************************************************/
 
-#include <Arduino.h>
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
 #include "tb_display.h"
+#include "tb_display_config.h"
+#include "tb_display_backend.h"
+#include "tb_display_charset.h"
+#include "tb_display_glyph_cache.h"
+#include "tb_display_scrollback.h"
+#include "tb_display_snapshot.h"
+#include "tb_display_stats.h"
+#include "tb_display_viewport.h"
 
-// Choose the type of M5Stick here:
-// #define M5STICKC
-#define M5STICKCPLUS
-
-// TextSize 1 is very small on the display = hard to read
-// Textsize 2 is good readable without the need of an microscope.
-// This code only runs with text size 2!
-#define TEXT_SIZE 2
-#define TEXT_HEIGHT 16 // Height of text to be printed
-// Display size of M5StickC     = 160x80
-// Display size of M5StickCPlus = 240*135
-// With TEXT_HEIGHT=16, the screen can display:
-// M5StickC:
-//    5 rows of text in portrait mode
-//   10 rows of text in landscape mode
-// M5StcikCPlus:
-//    8 rows of text in portrait mode
-//   15 rows of text in landscape mode
-
-// M5StickC:
-// Display size of M5StickC = 160x80
-// screen buffer for 10 rows of 60 characters max.
-#ifdef M5STICKC
-  // import the right lib
-  #include <M5StickC.h>
-  #define SCREEN_WIDTH 160
-  #define SCREEN_HEIGHT 80
-  #define TEXT_BUFFER_HEIGHT_WIDE 10
-  #define TEXT_BUFFER_HEIGHT_NARROW 5
-  #define TEXT_BUFFER_LINE_LENGTH_WIDE 60
-  #define TEXT_BUFFER_LINE_LENGTH_NARROW 30
-#endif
-// M5StickCPlus:
-// Display size of M5StickCPlus = 240*135
-// screen buffer for 15 rows of 90 characters max.
-#ifdef M5STICKCPLUS
-  // import the right lib
-  #include "M5StickCPlus.h"
-  #define SCREEN_WIDTH 240
-  #define SCREEN_HEIGHT 135
-  #define TEXT_BUFFER_HEIGHT_WIDE 15
-  #define TEXT_BUFFER_HEIGHT_NARROW 8
-  #define TEXT_BUFFER_LINE_LENGTH_WIDE 90
-  #define TEXT_BUFFER_LINE_LENGTH_NARROW 45
-#endif
+// the board type, the screen size and the text buffer size
+// are defined in tb_display_config.h
+
+// all drawing is done by the backend
+static const tb_display_backend *tb_backend = &TB_DISPLAY_DEFAULT_BACKEND;
+
+// in portrait mode, a row has max. 30 characters
+#define TEXT_BUFFER_LINE_LENGTH_PORTRAIT 30
+
+// the text buffer of the screen
+// landscape mode: few long rows, portrait mode: many short rows
+// Both modes use the same memory.
+union {
+  tb_display_storage<TEXT_BUFFER_HEIGHT_NARROW, TEXT_BUFFER_LINE_LENGTH_WIDE> landscape;
+  tb_display_storage<TEXT_BUFFER_HEIGHT_WIDE, TEXT_BUFFER_LINE_LENGTH_PORTRAIT> portrait;
+} text_buffer_memory;
+// the characters of the text buffer in the mode with more characters
+// (copied when the rotation changes)
+#define REFLOW_BYTES (sizeof(text_buffer_memory.landscape.text) > sizeof(text_buffer_memory.portrait.text) ? \
+                      sizeof(text_buffer_memory.landscape.text) : sizeof(text_buffer_memory.portrait.text))
 
-char text_buffer[TEXT_BUFFER_HEIGHT_WIDE][TEXT_BUFFER_LINE_LENGTH_WIDE];
+// the viewport of the screen used by the tb_display functions
+tb_display_viewport tb_screen;
 
-int text_buffer_height;
-int text_buffer_line_length;
-int text_buffer_write_pointer_x;
-int text_buffer_write_pointer_y;
-int text_buffer_read_pointer_y;
 // with M5.Lcd.setRotation(1) 
 // the position 0,0 is the upper left corner
 // starting a bit more right...
 #define SCREEN_XSTARTPOS 5
-int screen_xpos = SCREEN_XSTARTPOS;
-// start writing at the last line
-int screen_ypos;
-// maximum width of the screen
-int screen_max;
+// A small margin on the right side prevent false print results
+#define SCREEN_XMARGIN 2
+// width of the screen with the actual rotation
+int screen_width;
 
 // Enable or disable Waord Wrap
 boolean tb_display_word_wrap = true;
 
+// Enable or disable the UTF-8 decoding
+boolean tb_display_utf8 = true;
+
+// Enable or disable the escape sequences
+boolean tb_display_ansi = false;
+// state of the escape sequence parser
+#define ANSI_NONE 0 // normal characters
+#define ANSI_ESC  1 // after ESC
+#define ANSI_CSI  2 // after ESC [
+#define ANSI_ESC_CHAR 27
+// the ANSI colors 0 - 15 in RGB565
+static const uint16_t ansi_palette[16] = {
+  0x0000, 0xA800, 0x0540, 0xAAA0, 0x0015, 0xA815, 0x0555, 0xAD55,
+  0x52AA, 0xFAAA, 0x57EA, 0xFFEA, 0x52BF, 0xFABF, 0x57FF, 0xFFFF
+};
+// the colors used by the backend for the next characters
+// The text color of the backend is not changed, before the first
+// character with other colors is drawn.
+uint8_t backend_attr = TB_ATTR_DEFAULT;
+
+// Enable or disable the hardware scroll of the LCD controller
+// (used with the next tb_display_init)
+boolean tb_display_hw_scroll = false;
+
+// Enable or disable the row sprite mode
+// (used with the next tb_display_init)
+boolean tb_display_row_sprite = false;
+// the characters are drawn off-screen and pushed in parts of
+// this width to the screen (0 = sprite not used)
+int row_sprite_width = 0;
+
+// rows at the top of the screen for the status fields
+// (used with the next tb_display_init)
+int tb_display_status_rows = 0;
+// the status fields
+// Each field is a viewport with one row, so only the changed
+// characters are drawn by tb_display_draw_row().
+typedef struct {
+  tb_display_storage<1, TB_DISPLAY_STATUS_LENGTH> memory;
+  tb_display_viewport vp;
+  bool used;
+  uint8_t attr;
+} tb_display_status;
+tb_display_status status_fields[TB_DISPLAY_STATUS_FIELDS];
+
+// width of the characters 32 - 127 in pixel
+// from the backend, or measured once with tb_display_init()
+uint8_t glyph_width_table[96];
+const uint8_t *glyph_width = glyph_width_table;
+
+// result of the layout of a new character
+#define TB_LAYOUT_APPEND   0 // the character fits into the row
+#define TB_LAYOUT_NEW_LINE 1 // the row is full, start a new row
+#define TB_LAYOUT_WRAP     2 // the character does not fit into the row
+
+// limited frame rate: the text buffer is changed without drawing
+// and tb_display_update() draws the changes
+// minimum time between two frames in milliseconds (0 = not limited)
+unsigned long frame_interval = 0;
+// maximum time from the first change to its frame (0 = not limited)
+unsigned long frame_latency = 0;
+
+// the changed part of each line of the text buffer:
+// the first character position that needs a redraw
+#define TEXT_BUFFER_CLEAN 0xFF
+
 
 // =============================================================
-// Initialization of the Text Buffer and Screen
-// ScreenRotation values:
-// 1 = Button right
-// 2 = Button above
-// 3 = Button left
-// 4 = Button below
-// Display size of M5StickC = 160x80pixel
-// With TEXT_HEIGHT=16, the screen can display:
-//    5 rows of text in landscape mode
-//   10 rows of text in portrait mode
+// select the backend for all following drawing
+// call tb_display_init() afterwards to setup the new screen
+// The cached characters were rendered by the old backend
+// and are removed. The new backend starts with the default colors.
 // =============================================================
-void tb_display_init(int ScreenRotation){
-  M5.Lcd.setRotation(ScreenRotation);
+void tb_display_set_backend(const tb_display_backend *backend){
+  if(backend != NULL && backend != tb_backend){
+    tb_backend = backend;
+    tb_display_glyph_cache_clear();
+    backend_attr = TB_ATTR_DEFAULT;
+    if(tb_backend->set_text_color != NULL)
+      tb_backend->set_text_color(ansi_palette[TB_ATTR_DEFAULT & 0x0F], ansi_palette[TB_ATTR_DEFAULT & 0x0F]);
+  }
+}
+
+// =============================================================
+// returns the actual backend
+// =============================================================
+const tb_display_backend *tb_display_get_backend(){
+  return tb_backend;
+}
+
+// =============================================================
+// returns the viewport of the tb_display functions
+// =============================================================
+tb_display_viewport *tb_display_screen_viewport(){
+  return &tb_screen;
+}
+
+// =============================================================
+// the characters of a line of the text buffer and
+// the x positions of the characters
+// =============================================================
+static inline char *tb_display_line_text(tb_display_viewport *vp, int line){
+  return vp->text + line*vp->line_length;
+}
+
+static inline uint8_t *tb_display_line_xpos(tb_display_viewport *vp, int line){
+  return vp->text_xpos + line*(vp->line_length+1);
+}
+
+static inline uint8_t *tb_display_line_attr(tb_display_viewport *vp, int line){
+  return vp->attr + line*vp->line_length;
+}
+
+// =============================================================
+// the characters on the screen in a row of the display memory and
+// the x positions of the characters
+// =============================================================
+static inline char *tb_display_slot_text(tb_display_viewport *vp, int slot){
+  return vp->screen_text + slot*vp->line_length;
+}
+
+static inline uint8_t *tb_display_slot_xpos(tb_display_viewport *vp, int slot){
+  return vp->screen_xpos + slot*(vp->line_length+1);
+}
+
+static inline uint8_t *tb_display_slot_attr(tb_display_viewport *vp, int slot){
+  return vp->screen_attr + slot*vp->line_length;
+}
+
+// =============================================================
+// the line of the text buffer with the last row of the screen
+// and the row of the screen with the write position
+// =============================================================
+static inline int tb_display_last_line(tb_display_viewport *vp){
+  return (vp->read_pointer_y + vp->rows - 1) % vp->rows;
+}
+
+static inline int tb_display_cursor_row(tb_display_viewport *vp){
+  return (vp->write_pointer_y - vp->read_pointer_y + vp->rows) % vp->rows;
+}
+
+// =============================================================
+// set the colors of the backend for the next characters
+// =============================================================
+static void tb_display_set_color(uint8_t attr){
+  if(attr == backend_attr || tb_backend->set_text_color == NULL)
+    return;
+  backend_attr = attr;
+  uint16_t color = ansi_palette[attr & 0x0F];
+  // black background: only the character is drawn
+  uint16_t bgcolor = (attr >> 4) == 0 ? color : ansi_palette[attr >> 4];
+  tb_backend->set_text_color(color, bgcolor);
+}
+
+// =============================================================
+// the row of the display memory for a row on the screen
+// row 0 is the top row of the screen
+// without hardware scroll this is the same
+// =============================================================
+static int tb_display_memory_row(tb_display_viewport *vp, int row){
+  if(!vp->hw_scroll_active)
+    return row;
+  return (row + vp->hw_scroll_offset/vp->row_height) % vp->rows;
+}
+
+// =============================================================
+// mark a line of the text buffer as changed
+// from the character position "charpos" to the end of the line
+// =============================================================
+static void tb_display_mark_changed(tb_display_viewport *vp){
+  if(!vp->changed){
+    vp->changed = true;
+    vp->changed_time = millis();
+  }
+}
+
+static void tb_display_mark_dirty(tb_display_viewport *vp, int line, int charpos){
+  if(charpos < vp->dirty_from[line])
+    vp->dirty_from[line] = charpos;
+  tb_display_mark_changed(vp);
+}
+
+static void tb_display_mark_all_dirty(tb_display_viewport *vp){
+  for(int line=0; line<vp->rows; line++)
+    vp->dirty_from[line] = 0;
+  tb_display_mark_changed(vp);
+}
+
+// =============================================================
+// the text buffer has changed
+// draw the changes now, or with the next tb_display_update()
+// if the frame rate is limited
+// =============================================================
+static void tb_display_changed(tb_display_viewport *vp){
+  if(frame_interval == 0)
+    tb_display_viewport_refresh(vp);
+}
+
+// =============================================================
+// width of a character in pixel
+// =============================================================
+static int tb_display_char_width(byte data){
+  if(data < 32)
+    return 0;
+  // the extended characters (tb_display_charset.h)
+  if(data > 127)
+    return tb_backend->char_width(data, TEXT_SIZE);
+  return glyph_width[data-32];
+}
+
+// =============================================================
+// the row sprite is used for the rows of the viewport
+// The sprite has the height of the font and is pushed up to
+// the right side of the screen.
+// =============================================================
+static bool tb_display_use_sprite(tb_display_viewport *vp){
+  return row_sprite_width > 0 && vp->row_height == TEXT_HEIGHT &&
+         vp->x + vp->width >= screen_width;
+}
+
+// =============================================================
+// draw the characters "text" at the position "charpos" of a screen row
+// in the off-screen sprite and push it to the screen
+// "attr" are the colors of the characters (NULL = default colors)
+// The sprite is pushed in parts of the sprite width until the
+// old end of the row is reached, so the old characters are erased.
+// Not more characters than a row of the viewport are drawn (a row of
+// the history can be longer after a rotation).
+// returns the x position after the last character
+// =============================================================
+static int tb_display_sprite_row(tb_display_viewport *vp, int slot, int charpos, const char *text, const uint8_t *attr, int old_end){
+  char *screen_text = tb_display_slot_text(vp, slot);
+  uint8_t *screen_attr = tb_display_slot_attr(vp, slot);
+  uint8_t *screen_xpos = tb_display_slot_xpos(vp, slot);
+  int yPos = vp->y + slot*vp->row_height;
+  int xPos = screen_xpos[charpos];
+  int sprite_xpos = xPos;
+  tb_backend->sprite_fill(TFT_BLACK);
+  while(xPos < vp->max_x && charpos < vp->line_length-1 && *text != '\0'){
+    screen_text[charpos] = *text;
+    screen_attr[charpos] = attr != NULL ? *attr++ : TB_ATTR_DEFAULT;
+    screen_xpos[charpos] = xPos;
+    tb_display_set_color(screen_attr[charpos]);
+    xPos += tb_backend->sprite_draw_char((uint8_t)*text,xPos-sprite_xpos,0,TEXT_SIZE);
+    TB_STATS_ADD(draw_chars, 1);
+    // the character reaches the end of the sprite
+    if(xPos >= sprite_xpos+row_sprite_width){
+      tb_backend->sprite_push(vp->x+sprite_xpos, yPos);
+      TB_STATS_ADD(pixels, row_sprite_width*TEXT_HEIGHT);
+      sprite_xpos += row_sprite_width;
+      tb_backend->sprite_fill(TFT_BLACK);
+      // the rest of the character in the next part
+      tb_backend->sprite_draw_char((uint8_t)*text,screen_xpos[charpos]-sprite_xpos,0,TEXT_SIZE);
+      TB_STATS_ADD(draw_chars, 1);
+    }
+    text++;
+    charpos++;
+  }
+  vp->screen_length[slot] = charpos;
+  screen_xpos[charpos] = xPos;
+  // push the last part and erase the rest of the old row
+  if(old_end < xPos)
+    old_end = xPos;
+  while(sprite_xpos < old_end){
+    tb_backend->sprite_push(vp->x+sprite_xpos, yPos);
+    TB_STATS_ADD(pixels, row_sprite_width*TEXT_HEIGHT);
+    sprite_xpos += row_sprite_width;
+    tb_backend->sprite_fill(TFT_BLACK);
+  }
+  return xPos;
+}
+
+// =============================================================
+// redraw the changed part of one row of the display memory
+// The characters and their colors are compared with the characters
+// on the screen, starting at the character position "charpos".
+// Only the characters behind the first difference are erased
+// and drawn again. If the characters behind the changed part stay
+// at the same position (e.g. a character replaced by a character
+// of the same width), only the changed part is drawn.
+// "attr" are the colors of the characters (NULL = default colors)
+// Not more characters than a row of the viewport are drawn (a row of
+// the history can be longer after a rotation).
+// =============================================================
+static void tb_display_draw_row(tb_display_viewport *vp, int slot, const char *text, const uint8_t *attr, int charpos){
+  char *screen_text = tb_display_slot_text(vp, slot);
+  uint8_t *screen_attr = tb_display_slot_attr(vp, slot);
+  uint8_t *screen_xpos = tb_display_slot_xpos(vp, slot);
+  int yPos = vp->y + slot*vp->row_height;
+  int length = vp->screen_length[slot];
+  // search the first character that is different on the screen
+  if(charpos > length)
+    charpos = length;
+  while(charpos < length && text[charpos] != '\0' &&
+        text[charpos] == screen_text[charpos] &&
+        (attr != NULL ? attr[charpos] : TB_ATTR_DEFAULT) == screen_attr[charpos])
+    charpos++;
+  if(tb_display_use_sprite(vp)){
+    tb_display_sprite_row(vp, slot, charpos, text+charpos, attr != NULL ? attr+charpos : NULL, screen_xpos[length]);
+    return;
+  }
+  // search the last character that is different on the screen
+  int last = length;
+  if(charpos < length && charpos + (int)strlen(text+charpos) == length){
+    while(last > charpos && text[last-1] == screen_text[last-1] &&
+          (attr != NULL ? attr[last-1] : TB_ATTR_DEFAULT) == screen_attr[last-1])
+      last--;
+    int xEnd = screen_xpos[charpos];
+    for(int n = charpos; n < last; n++)
+      xEnd += tb_display_char_width(text[n]);
+    if(last < length && xEnd == screen_xpos[last]){
+      // the rest of the row stays on the screen
+      tb_backend->fill_rect(vp->x+screen_xpos[charpos], yPos, xEnd-screen_xpos[charpos], vp->row_height, TFT_BLACK);
+      TB_STATS_ADD(pixels, (xEnd-screen_xpos[charpos])*vp->row_height);
+      int xPos = screen_xpos[charpos];
+      for(int n = charpos; n < last; n++){
+        screen_text[n] = text[n];
+        screen_attr[n] = attr != NULL ? attr[n] : TB_ATTR_DEFAULT;
+        screen_xpos[n] = xPos;
+        tb_display_set_color(screen_attr[n]);
+        int width = tb_backend->draw_char((uint8_t)text[n],vp->x+xPos,yPos,TEXT_SIZE);
+        TB_STATS_ADD(draw_chars, 1);
+        TB_STATS_ADD(pixels, width*TEXT_HEIGHT);
+        xPos += width;
+      }
+      return;
+    }
+  }
+  // erase the old characters behind this position
+  int xPos = screen_xpos[charpos];
+  int old_end = screen_xpos[length];
+  if(old_end > xPos){
+    tb_backend->fill_rect(vp->x+xPos, yPos, old_end-xPos, vp->row_height, TFT_BLACK);
+    TB_STATS_ADD(pixels, (old_end-xPos)*vp->row_height);
+  }
+  // and draw the new characters
+  while(xPos < vp->max_x && charpos < vp->line_length-1 && text[charpos] != '\0'){
+    screen_text[charpos] = text[charpos];
+    screen_attr[charpos] = attr != NULL ? attr[charpos] : TB_ATTR_DEFAULT;
+    screen_xpos[charpos] = xPos;
+    tb_display_set_color(screen_attr[charpos]);
+    int width = tb_backend->draw_char((uint8_t)text[charpos],vp->x+xPos,yPos,TEXT_SIZE);
+    TB_STATS_ADD(draw_chars, 1);
+    TB_STATS_ADD(pixels, width*TEXT_HEIGHT);
+    xPos += width;
+    charpos++;
+  }
+  vp->screen_length[slot] = charpos;
+  screen_xpos[charpos] = xPos;
+}
+
+// =============================================================
+// redraw the changed part of one row of the screen
+// row 0 is the top row of the screen
+// =============================================================
+static void tb_display_refresh_row(tb_display_viewport *vp, int row){
+  // modulo operation for line position
+  int line = (vp->read_pointer_y+row) % vp->rows;
+  if(vp->dirty_from[line] == TEXT_BUFFER_CLEAN)
+    return;
+  tb_display_draw_row(vp, tb_display_memory_row(vp, row), tb_display_line_text(vp, line),
+                      tb_display_line_attr(vp, line), vp->dirty_from[line]);
+  vp->dirty_from[line] = TEXT_BUFFER_CLEAN;
+}
+
+// =============================================================
+// the number of rows the screen can be scrolled back
+// =============================================================
+static int tb_display_scrollback_max(tb_display_viewport *vp){
+  if(!vp->history)
+    return 0;
+  return tb_display_scrollback_count();
+}
+
+// =============================================================
+// draw a character at the actual write position
+// the character is drawn directly on the screen and
+// also stored as shown on the screen
+// In a batch or with a limited frame rate, the character is only
+// marked for the refresh
+// =============================================================
+static void tb_display_draw_char(tb_display_viewport *vp, byte data, uint8_t attr){
+  int slot = tb_display_memory_row(vp, tb_display_cursor_row(vp));
+  int charpos = vp->write_pointer_x;
+  if(vp->batch || frame_interval > 0 || vp->scrollback_view > 0 ||
+     vp->dirty_from[vp->write_pointer_y] != TEXT_BUFFER_CLEAN){
+    // only the layout, the row is drawn at the end of the batch,
+    // with the next frame or if the screen shows the actual rows again
+    tb_display_mark_dirty(vp, vp->write_pointer_y, charpos);
+    return;
+  }
+  char *screen_text = tb_display_slot_text(vp, slot);
+  uint8_t *screen_xpos = tb_display_slot_xpos(vp, slot);
+  if(tb_display_use_sprite(vp)){
+    // the row is empty behind the actual write position
+    char text[2] = {(char)data, '\0'};
+    screen_xpos[charpos] = vp->cursor_x;
+    tb_display_sprite_row(vp, slot, charpos, text, &attr, vp->cursor_x);
+    return;
+  }
+  screen_text[charpos] = data;
+  tb_display_slot_attr(vp, slot)[charpos] = attr;
+  screen_xpos[charpos] = vp->cursor_x;
+  vp->screen_length[slot] = charpos+1;
+  tb_display_set_color(attr);
+  int width = tb_backend->draw_char(data,vp->x+vp->cursor_x,vp->y+slot*vp->row_height,TEXT_SIZE);
+  TB_STATS_ADD(draw_chars, 1);
+  TB_STATS_ADD(pixels, width*TEXT_HEIGHT);
+  screen_xpos[charpos+1] = vp->cursor_x + width;
+}
+
+// =============================================================
+// layout of a new character at the end of a row
+// Only the widths of the characters are used, nothing is drawn.
+// row     = the characters of the row
+// charpos = position of the new character in the row
+// xpos    = x position of the new character on the screen
+// returns TB_LAYOUT_APPEND, TB_LAYOUT_NEW_LINE or TB_LAYOUT_WRAP
+// For TB_LAYOUT_WRAP with Word-Wrap, space_pos is the position
+// of the space character in front of the last word. The word is
+// moved into the new row. Otherwise space_pos is -1.
+// =============================================================
+static int tb_display_layout_char(tb_display_viewport *vp, const char *row, int charpos, int xpos, byte data, int *space_pos){
+  *space_pos = -1;
+  // if maximum number of characters reached
+  if(charpos >= vp->line_length-1)
+    return TB_LAYOUT_NEW_LINE;
+  if(xpos + tb_display_char_width(data) < vp->max_x)
+    return TB_LAYOUT_APPEND;
+  // or if line wrap is reached
+  // if Word-Wrap, go backwards and get the last "word" by finding the
+  // last space character. A space character as the first character
+  // of the row does not count. If the character that causes the
+  // word wrap is a space character, no word has to be moved.
+  // (only at the end of the row, not inside of a row)
+  if(tb_display_word_wrap && data != ' ' && row[charpos] == '\0'){
+    int test_pos = charpos-1;
+    while(test_pos > 0 && row[test_pos] != ' ')
+      test_pos--;
+    if(test_pos > 0)
+      *space_pos = test_pos;
+  }
+  return TB_LAYOUT_WRAP;
+}
+
+// =============================================================
+// calculate the x positions of a line from the character position
+// "charpos" to the end of the line
+// The characters that do not fit into the row anymore are removed.
+// =============================================================
+static void tb_display_layout_line(tb_display_viewport *vp, int line, int charpos){
+  char *text = tb_display_line_text(vp, line);
+  uint8_t *text_xpos = tb_display_line_xpos(vp, line);
+  int xpos = text_xpos[charpos];
+  while(text[charpos] != '\0'){
+    int width = tb_display_char_width(text[charpos]);
+    if(xpos + width >= vp->max_x){
+      text[charpos] = '\0';
+      break;
+    }
+    text_xpos[charpos] = xpos;
+    xpos += width;
+    charpos++;
+  }
+  text_xpos[charpos] = xpos;
+}
+
+// =============================================================
+// add a character at the actual write position
+// with the colors "attr"
+// The layout has checked that the character fits into the row.
+// Inside of a row (after an escape sequence moved the write
+// position), the character replaces the old character.
+// =============================================================
+static void tb_display_put_char(tb_display_viewport *vp, byte data, uint8_t attr){
+  char *text = tb_display_line_text(vp, vp->write_pointer_y);
+  uint8_t *text_xpos = tb_display_line_xpos(vp, vp->write_pointer_y);
+  int charpos = vp->write_pointer_x;
+  if(text[charpos] != '\0'){
+    // the following characters move with the width of the new character
+    text[charpos] = data;
+    tb_display_line_attr(vp, vp->write_pointer_y)[charpos] = attr;
+    tb_display_layout_line(vp, vp->write_pointer_y, charpos);
+    tb_display_mark_dirty(vp, vp->write_pointer_y, charpos);
+    vp->cursor_x = text_xpos[charpos+1];
+    vp->write_pointer_x++;
+    if(!vp->batch)
+      tb_display_changed(vp);
+    return;
+  }
+  text[charpos] = data;
+  tb_display_line_attr(vp, vp->write_pointer_y)[charpos] = attr;
+  // following character a null terminator to clear the old characters of the line
+  text[charpos+1] = '\0';
+  text_xpos[charpos] = vp->cursor_x;
+  tb_display_draw_char(vp, data, attr);
+  vp->cursor_x += tb_display_char_width(data);
+  text_xpos[charpos+1] = vp->cursor_x;
+  vp->write_pointer_x++;
+  // the history view also shows the top rows of the text buffer
+  if(vp->scrollback_view > 0 && vp->scrollback_view + tb_display_cursor_row(vp) < vp->rows && !vp->batch)
+    tb_display_changed(vp);
+}
+
+// =============================================================
+// the screen and the text buffer memory for a rotation
+// (without clearing the text buffer)
+// =============================================================
+static void tb_display_setup(int ScreenRotation){
+  tb_backend->set_rotation(ScreenRotation);
   switch (ScreenRotation) {
     case 1: case 3: {
       // 5 rows of text in landscape mode
-      text_buffer_height = TEXT_BUFFER_HEIGHT_NARROW;
-      text_buffer_line_length = TEXT_BUFFER_LINE_LENGTH_WIDE;
+      text_buffer_memory.landscape.attach(&tb_screen);
       // width of the screen in landscape mode
-      // A small margin on the right side prevent false print results
-      screen_max = SCREEN_WIDTH-2; 
+      screen_width = tb_backend->screen_width;
       break;
     }
     case 2: case 4: {
       // 10 rows of text in portrait mode
-      text_buffer_height = TEXT_BUFFER_HEIGHT_WIDE;
-      text_buffer_line_length = 30;
+      text_buffer_memory.portrait.attach(&tb_screen);
       // width of the screen in portrait mode
-      // A small margin on the right side prevent false print results
-      screen_max = SCREEN_HEIGHT-2; 
+      screen_width = tb_backend->screen_height;
       break;
     }
     default: {
       break;
     }
   }
+  // the status rows at the top of the screen
+  int status_rows = tb_display_status_rows;
+  if(status_rows > tb_screen.rows-1)
+    status_rows = tb_screen.rows-1;
+  if(status_rows < 0)
+    status_rows = 0;
+  tb_screen.rows -= status_rows;
+  tb_screen.x = 0;
+  tb_screen.y = status_rows*TEXT_HEIGHT;
+  tb_screen.width = screen_width;
+  tb_screen.row_height = TEXT_HEIGHT;
+  tb_screen.history = tb_display_scrollback_begin();
+  tb_screen.batch = false;
+  // the widths of the characters
+  if(tb_backend->glyph_widths != NULL){
+    glyph_width = tb_backend->glyph_widths;
+  } else {
+    for(int c=32; c<128; c++)
+      glyph_width_table[c-32] = tb_backend->char_width(c, TEXT_SIZE);
+    glyph_width = glyph_width_table;
+  }
+  // the hardware scroll moves the display memory in steps of full
+  // text rows. This requires that the rows fill the screen completely.
+  // (only in portrait mode, the height is the long side of the screen)
+  tb_screen.hw_scroll_active = false;
+  tb_screen.hw_scroll_offset = 0;
+  tb_screen.hw_scroll_shown = 0;
+  if(tb_backend->scroll_init != NULL){
+    bool possible = tb_backend->scroll_init(ScreenRotation);
+    if(tb_display_hw_scroll && possible && tb_screen.rows*TEXT_HEIGHT == tb_backend->screen_width)
+      tb_screen.hw_scroll_active = true;
+  }
+  // the sprite for the row sprite mode
+  row_sprite_width = 0;
+  if(tb_display_row_sprite && tb_backend->sprite_create != NULL){
+    int width = TB_DISPLAY_SPRITE_BUDGET/(TEXT_HEIGHT*2);
+    // not smaller than the widest character
+    if(width < TEXT_HEIGHT)
+      width = TEXT_HEIGHT;
+    if(width > screen_width)
+      width = screen_width;
+    if(tb_backend->sprite_create(width, TEXT_HEIGHT))
+      row_sprite_width = width;
+  }
+}
+
+// =============================================================
+// Initialization of the Text Buffer and Screen
+// ScreenRotation values:
+// 1 = Button right
+// 2 = Button above
+// 3 = Button left
+// 4 = Button below
+// Display size of M5StickC = 160x80pixel
+// With TEXT_HEIGHT=16, the screen can display:
+//    5 rows of text in landscape mode
+//   10 rows of text in portrait mode
+// A valid snapshot of the rows is shown instead of an empty screen
+// =============================================================
+void tb_display_init(int ScreenRotation){
+  tb_display_setup(ScreenRotation);
   tb_display_clear();
+  // the rows before the deep sleep (see tb_display_snapshot.h)
+  if(tb_display_snapshot_load(&tb_screen)){
+    for(int line = 0; line < tb_screen.rows; line++)
+      tb_display_layout_line(&tb_screen, line, 0);
+    // the empty rows at the top were never written
+    int blank = 0;
+    while(blank < tb_display_cursor_row(&tb_screen)){
+      int line = (tb_screen.read_pointer_y + blank) % tb_screen.rows;
+      if(tb_display_line_text(&tb_screen, line)[0] != '\0' || tb_screen.row_end[line] != TB_ROW_END)
+        break;
+      blank++;
+    }
+    tb_screen.blank_rows = blank;
+    int length = strlen(tb_display_line_text(&tb_screen, tb_screen.write_pointer_y));
+    if(tb_screen.write_pointer_x > length)
+      tb_screen.write_pointer_x = length;
+    tb_screen.cursor_x = tb_display_line_xpos(&tb_screen, tb_screen.write_pointer_y)[tb_screen.write_pointer_x];
+  }
   tb_display_show();
 }
 
+// =============================================================
+// setup a viewport: clear the text buffer and the viewport
+// =============================================================
+void tb_display_viewport_begin(tb_display_viewport *vp){
+  tb_display_viewport_clear(vp);
+  tb_display_viewport_show(vp);
+}
+
+// =============================================================
+// empty all rows of the text buffer (the history is kept)
+// =============================================================
+static void tb_display_reset(tb_display_viewport *vp){
+  for(int line=0; line<vp->rows; line++){
+    char *text = tb_display_line_text(vp, line);
+    for(int charpos=0; charpos<vp->line_length; charpos++){
+      text[charpos]='\0';
+    }
+    tb_display_line_xpos(vp, line)[0] = SCREEN_XSTARTPOS;
+    vp->row_end[line] = TB_ROW_END;
+  }
+  tb_display_mark_all_dirty(vp);
+  vp->scrollback_view = 0;
+  vp->max_x = vp->width - SCREEN_XMARGIN;
+  vp->read_pointer_y = 0;
+  vp->write_pointer_x = 0;
+  vp->write_pointer_y = vp->rows-1;
+  vp->blank_rows = vp->rows-1;
+  vp->cursor_x = SCREEN_XSTARTPOS;
+  vp->text_attr = TB_ATTR_DEFAULT;
+  vp->ansi_state = ANSI_NONE;
+  vp->ansi_bold = false;
+  vp->utf8_count = 0;
+}
+
 // =============================================================
 // clear the text buffer
 // without refreshing the screen
 // call tb_display_show(); to clear the screen
 // =============================================================
+void tb_display_viewport_clear(tb_display_viewport *vp){
+  tb_display_reset(vp);
+  if(vp->history)
+    tb_display_scrollback_clear();
+}
+
 void tb_display_clear(){
-  for(int line=0; line<TEXT_BUFFER_HEIGHT_WIDE; line++){
-    for(int charpos=0; charpos<TEXT_BUFFER_LINE_LENGTH_WIDE; charpos++){
-      text_buffer[line][charpos]='\0';
+  tb_display_viewport_clear(&tb_screen);
+}
+
+// =============================================================
+// copy the rows of the screen up to the write position into
+// "text" and "attr" as logical lines
+// The wrapped rows are joined again, the lines end with '\n'.
+// The empty rows at the top of a screen that was not filled yet
+// are left out (without history: all empty rows at the top).
+// returns the number of characters
+// "rows" = the number of copied rows
+// =============================================================
+static int tb_display_reflow_save(tb_display_viewport *vp, char *text, uint8_t *attr, int *rows){
+  int last = tb_display_cursor_row(vp);
+  int row = 0;
+  int blank = vp->history ? vp->blank_rows : last;
+  while(row < last && row < blank){
+    int line = (vp->read_pointer_y + row) % vp->rows;
+    if(tb_display_line_text(vp, line)[0] != '\0' || vp->row_end[line] != TB_ROW_END)
+      break;
+    row++;
+  }
+  *rows = last + 1 - row;
+  int length = 0;
+  for(; row <= last; row++){
+    int line = (vp->read_pointer_y + row) % vp->rows;
+    const char *row_text = tb_display_line_text(vp, line);
+    const uint8_t *row_attr = tb_display_line_attr(vp, line);
+    for(int charpos = 0; row_text[charpos] != '\0'; charpos++){
+      text[length] = row_text[charpos];
+      attr[length++] = row_attr[charpos];
+    }
+    if(row < last && vp->row_end[line] != TB_ROW_WRAP){
+      text[length] = vp->row_end[line] == TB_ROW_END ? '\n' : ' ';
+      attr[length++] = TB_ATTR_DEFAULT;
+    }
+  }
+  return length;
+}
+
+// =============================================================
+// a logical line starts with row n of the history
+// =============================================================
+static bool tb_display_reflow_line_start(int n){
+  return n == 0 || tb_display_scrollback_row_end(n-1) == TB_ROW_END;
+}
+
+// =============================================================
+// take the last rows of the history in front of the copied lines
+// until they are at least "rows" rows and a logical line starts
+// with the first one (as long as they fit into "text")
+// These rows are removed from the history and laid out again.
+// returns the new number of characters
+// =============================================================
+static int tb_display_reflow_history(char *text, uint8_t *attr, int length, int rows){
+  int count = tb_display_scrollback_count();
+  int first = count;
+  int bytes = 0;
+  int size = 0;
+  int n = count;
+  while(n > 0 && (count-n < rows || !tb_display_reflow_line_start(n))){
+    n--;
+    size += strlen(tb_display_scrollback_row(n));
+    if(tb_display_scrollback_row_end(n) != TB_ROW_WRAP)
+      size++;
+    if(length + size > (int)REFLOW_BYTES)
+      break;
+    if(tb_display_reflow_line_start(n)){
+      first = n;
+      bytes = size;
+    }
+  }
+  if(first == count)
+    return length;
+  memmove(text+bytes, text, length);
+  memmove(attr+bytes, attr, length);
+  int pos = 0;
+  for(n = first; n < count; n++){
+    const char *row = tb_display_scrollback_row(n);
+    while(*row != '\0'){
+      text[pos] = *row++;
+      attr[pos++] = TB_ATTR_DEFAULT;
+    }
+    if(tb_display_scrollback_row_end(n) != TB_ROW_WRAP){
+      text[pos] = tb_display_scrollback_row_end(n) == TB_ROW_END ? '\n' : ' ';
+      attr[pos++] = TB_ATTR_DEFAULT;
     }
   }
-  text_buffer_read_pointer_y = 0;
-  text_buffer_write_pointer_x = 0;
-  text_buffer_write_pointer_y = text_buffer_height-1;
-  screen_xpos = SCREEN_XSTARTPOS;
-  screen_ypos = TEXT_HEIGHT*(text_buffer_height-1);
+  for(n = first; n < count; n++)
+    tb_display_scrollback_pop();
+  return length + bytes;
+}
+
+// =============================================================
+// change the rotation of the screen and keep the text
+// Only the logical lines that are visible with the new rotation
+// are laid out again, the screen is drawn once.
+// =============================================================
+void tb_display_set_rotation(int ScreenRotation){
+  tb_display_viewport *vp = &tb_screen;
+  if(vp->text == NULL){
+    // nothing to keep before the first tb_display_init()
+    tb_display_init(ScreenRotation);
+    return;
+  }
+  // both rotations use the same memory: copy the lines first
+  char text[REFLOW_BYTES];
+  uint8_t attr[REFLOW_BYTES];
+  int rows;
+  int length = tb_display_reflow_save(vp, text, attr, &rows);
+  uint8_t text_attr = vp->text_attr;
+  tb_display_setup(ScreenRotation);
+  // more rows on the screen: the last lines of the history as well
+  if(vp->history)
+    length = tb_display_reflow_history(text, attr, length, vp->rows - rows);
+  tb_display_reset(vp);
+  // lay out the lines without drawing
+  // (the rows that do not fit onto the screen go into the history)
+  vp->batch = true;
+  for(int n = 0; n < length; n++){
+    vp->text_attr = attr[n];
+    tb_display_viewport_print_char(vp, text[n]);
+  }
+  vp->batch = false;
+  vp->text_attr = text_attr;
+  tb_display_show();
+}
+
+// =============================================================
+// draw all rows of the viewport again
+// after the screen was erased
+// =============================================================
+static void tb_display_repaint(tb_display_viewport *vp){
+  // nothing is on the screen anymore
+  for(int slot=0; slot<vp->rows; slot++){
+    vp->screen_length[slot] = 0;
+    tb_display_slot_xpos(vp, slot)[0] = SCREEN_XSTARTPOS;
+  }
+  tb_display_mark_all_dirty(vp);
+  tb_display_viewport_refresh(vp);
+}
+
+// =============================================================
+// a status field is on the screen: inside of the status rows
+// and inside of the screen
+// =============================================================
+static bool tb_display_status_visible(tb_display_status *field){
+  return field->used && field->vp.y < tb_screen.y && field->vp.x < screen_width;
+}
+
+// =============================================================
+// draw all status fields again after the screen was erased
+// =============================================================
+static void tb_display_status_repaint(){
+  for(int n = 0; n < TB_DISPLAY_STATUS_FIELDS; n++){
+    tb_display_status *field = &status_fields[n];
+    if(!field->used)
+      continue;
+    field->vp.screen_length[0] = 0;
+    field->vp.screen_xpos[0] = SCREEN_XSTARTPOS;
+    if(tb_display_status_visible(field))
+      tb_display_draw_row(&field->vp, 0, field->vp.text, field->vp.attr, 0);
+  }
 }
 
 // =============================================================
 // clear the screen and display the text buffer
 // =============================================================
+void tb_display_viewport_show(tb_display_viewport *vp){
+  TB_STATS_TIME(show_time);
+  tb_backend->fill_rect(vp->x, vp->y, vp->width, vp->rows*vp->row_height, TFT_BLACK);
+  TB_STATS_ADD(pixels, vp->width*vp->rows*vp->row_height);
+  tb_display_repaint(vp);
+}
+
 void tb_display_show(){
-  M5.Lcd.fillScreen(TFT_BLACK);
-  int yPos = 0;
-  int xPos = 0;
-  int charpos = 0;
-  for(int n=0; n<text_buffer_height; n++){
-    // modulo operation for line position
-    int line = (text_buffer_read_pointer_y+n) % text_buffer_height;
-    xPos = SCREEN_XSTARTPOS;
-    charpos = 0;
-    while(xPos < screen_max && text_buffer[line][charpos] != '\0'){
-      xPos += M5.Lcd.drawChar(text_buffer[line][charpos],xPos,yPos,TEXT_SIZE);
-      charpos++;
+  TB_STATS_TIME(show_time);
+  tb_backend->fill_screen(TFT_BLACK);
+  TB_STATS_ADD(pixels, tb_backend->screen_width*tb_backend->screen_height);
+  tb_display_repaint(&tb_screen);
+  tb_display_status_repaint();
+}
+
+// =============================================================
+// redraw only the changed rows of the text buffer
+// =============================================================
+void tb_display_viewport_refresh(tb_display_viewport *vp){
+  TB_STATS_TIME(refresh_time);
+  vp->changed = false;
+  // the LCD controller shows the rows from the new scroll offset
+  if(vp->hw_scroll_active && vp->hw_scroll_shown != vp->hw_scroll_offset){
+    tb_backend->scroll_to(vp->hw_scroll_offset);
+    vp->hw_scroll_shown = vp->hw_scroll_offset;
+  }
+  if(vp->scrollback_view > 0){
+    // show the rows from the history
+    // the rows are drawn directly from the history without a copy
+    // and are followed by the top rows of the text buffer
+    int count = tb_display_scrollback_count();
+    int first = count - vp->scrollback_view;
+    for(int n=0; n<vp->rows; n++){
+      int row = first + n;
+      if(row < count){
+        tb_display_draw_row(vp, tb_display_memory_row(vp, n), tb_display_scrollback_row(row), NULL, 0);
+      } else {
+        int line = (vp->read_pointer_y + row - count) % vp->rows;
+        tb_display_draw_row(vp, tb_display_memory_row(vp, n), tb_display_line_text(vp, line),
+                            tb_display_line_attr(vp, line), 0);
+      }
     }
-    yPos = yPos + TEXT_HEIGHT;
+    TB_STATS_ADD(full_refreshes, 1);
+    return;
+  }
+#if TB_DISPLAY_STATS
+  int dirty_rows = 0;
+  for(int line=0; line<vp->rows; line++){
+    if(vp->dirty_from[line] != TEXT_BUFFER_CLEAN)
+      dirty_rows++;
   }
-  // screen_xpos is the actual pos after printing the last line
-  screen_xpos = xPos; 
-  text_buffer_write_pointer_x = charpos;
+  if(dirty_rows == vp->rows)
+    TB_STATS_ADD(full_refreshes, 1);
+  else if(dirty_rows > 0)
+    TB_STATS_ADD(partial_refreshes, 1);
+#endif
+  for(int n=0; n<vp->rows; n++)
+    tb_display_refresh_row(vp, n);
+}
+
+void tb_display_refresh(){
+  tb_display_viewport_refresh(&tb_screen);
 }
 
 // =============================================================
-// creates a new line and scroll the display upwards
+// scroll the screen back into the history
+// rows > 0 = show older rows
+// rows < 0 = show newer rows
 // =============================================================
-void tb_display_new_line(){
-  text_buffer_write_pointer_x = 0;
-  text_buffer_write_pointer_y++;
-  text_buffer_read_pointer_y++;
+static void tb_display_viewport_scroll_back(tb_display_viewport *vp, int rows){
+  int view = vp->scrollback_view + rows;
+  if(view > tb_display_scrollback_max(vp))
+    view = tb_display_scrollback_max(vp);
+  if(view < 0)
+    view = 0;
+  if(view == vp->scrollback_view)
+    return;
+  vp->scrollback_view = view;
+  // back to the actual rows: compare all rows with the screen
+  if(vp->scrollback_view == 0)
+    tb_display_mark_all_dirty(vp);
+  tb_display_viewport_refresh(vp);
+}
+
+void tb_display_scroll_back(int rows){
+  tb_display_viewport_scroll_back(&tb_screen, rows);
+}
+
+// =============================================================
+// scroll one page back or forward
+// one row of the old page stays on the screen
+// =============================================================
+void tb_display_page_up(){
+  tb_display_scroll_back(tb_screen.rows-1);
+}
+
+void tb_display_page_down(){
+  tb_display_scroll_back(-(tb_screen.rows-1));
+}
+
+// =============================================================
+// number of rows the screen is scrolled back
+// =============================================================
+int tb_display_scroll_position(){
+  return tb_screen.scrollback_view;
+}
+
+// =============================================================
+// continue in the next row and scroll the display upwards
+// row_end = how the actual row ends (TB_ROW_END, ...)
+// =============================================================
+static void tb_display_next_row(tb_display_viewport *vp, uint8_t row_end){
+  vp->row_end[vp->write_pointer_y] = row_end;
+  if(vp->write_pointer_y != tb_display_last_line(vp)){
+    // the write position was moved up with an escape sequence:
+    // continue at the start of the next row without scrolling
+    vp->write_pointer_y = (vp->write_pointer_y + 1) % vp->rows;
+    vp->write_pointer_x = 0;
+    vp->cursor_x = SCREEN_XSTARTPOS;
+    return;
+  }
+  // the top row scrolls out and is added to the history
+  // (the empty rows of a screen that was not filled yet are left out)
+  int top = vp->read_pointer_y;
+  bool added = false;
+  if(vp->blank_rows > 0 && tb_display_line_text(vp, top)[0] == '\0' && vp->row_end[top] == TB_ROW_END){
+    vp->blank_rows--;
+  } else {
+    vp->blank_rows = 0;
+    if(vp->history){
+      tb_display_scrollback_append(tb_display_line_text(vp, top), vp->row_end[top]);
+      added = true;
+    }
+  }
+  vp->write_pointer_x = 0;
+  vp->write_pointer_y++;
+  vp->read_pointer_y++;
   // circular buffer...
-  if(text_buffer_write_pointer_y >= text_buffer_height)
-    text_buffer_write_pointer_y = 0;
-  if(text_buffer_read_pointer_y >= text_buffer_height)
-    text_buffer_read_pointer_y = 0;
+  if(vp->write_pointer_y >= vp->rows)
+    vp->write_pointer_y = 0;
+  if(vp->read_pointer_y >= vp->rows)
+    vp->read_pointer_y = 0;
   // clear the actual new line for writing (first character a null terminator)
-  text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = '\0';
-  tb_display_show();
+  tb_display_line_text(vp, vp->write_pointer_y)[vp->write_pointer_x] = '\0';
+  tb_display_line_xpos(vp, vp->write_pointer_y)[0] = SCREEN_XSTARTPOS;
+  vp->cursor_x = SCREEN_XSTARTPOS;
+  if(vp->scrollback_view > 0){
+    // the screen shows the history: the same rows stay on the screen
+    // the actual rows are compared with the screen when they are shown again
+    if(added)
+      vp->scrollback_view++;
+    if(vp->scrollback_view > tb_display_scrollback_max(vp))
+      vp->scrollback_view = tb_display_scrollback_max(vp);
+  } else if(vp->hw_scroll_active){
+    // let the LCD controller scroll the screen content one row up
+    // the new row at the bottom shows the old top row and is erased
+    // by the refresh. The row above may have lost a wrapped word.
+    // (the LCD controller gets the new offset with the refresh)
+    vp->hw_scroll_offset = (vp->hw_scroll_offset + vp->row_height) % (vp->rows*vp->row_height);
+    int last_line = (vp->write_pointer_y + vp->rows - 1) % vp->rows;
+    tb_display_mark_dirty(vp, last_line, 0);
+    tb_display_mark_dirty(vp, vp->write_pointer_y, 0);
+  } else {
+    // all rows moved one row up on the screen
+    tb_display_mark_all_dirty(vp);
+  }
+  if(!vp->batch)
+    tb_display_changed(vp);
+}
+
+// =============================================================
+// creates a new line and scroll the display upwards
+// =============================================================
+void tb_display_viewport_new_line(tb_display_viewport *vp){
+  tb_display_next_row(vp, TB_ROW_END);
+}
+
+void tb_display_new_line(){
+  tb_display_viewport_new_line(&tb_screen);
+}
+
+// =============================================================
+// move the write position to a row and a column of the viewport
+// row 0 is the top row, column 0 is the first character of the row
+// A shorter row is filled up with space characters, as long as
+// they fit into the row.
+// =============================================================
+static void tb_display_cursor_to(tb_display_viewport *vp, int row, int column){
+  if(row < 0)
+    row = 0;
+  if(row > vp->rows-1)
+    row = vp->rows-1;
+  if(column < 0)
+    column = 0;
+  int line = (vp->read_pointer_y + row) % vp->rows;
+  char *text = tb_display_line_text(vp, line);
+  uint8_t *text_xpos = tb_display_line_xpos(vp, line);
+  int charpos = strlen(text);
+  int space_width = tb_display_char_width(' ');
+  if(charpos < column)
+    tb_display_mark_dirty(vp, line, charpos);
+  while(charpos < column && charpos < vp->line_length-1 &&
+        text_xpos[charpos] + space_width < vp->max_x){
+    text[charpos] = ' ';
+    tb_display_line_attr(vp, line)[charpos] = TB_ATTR_DEFAULT;
+    text_xpos[charpos+1] = text_xpos[charpos] + space_width;
+    charpos++;
+    text[charpos] = '\0';
+  }
+  if(column > charpos)
+    column = charpos;
+  vp->write_pointer_y = line;
+  vp->write_pointer_x = column;
+  vp->cursor_x = text_xpos[column];
+}
+
+// =============================================================
+// erase a part of a line of the text buffer
+// from the character position "from" to the position "to"
+// (to = -1: to the end of the line)
+// The erased characters in front of the rest of the line are
+// replaced with space characters.
+// =============================================================
+static void tb_display_erase(tb_display_viewport *vp, int line, int from, int to){
+  char *text = tb_display_line_text(vp, line);
+  uint8_t *attr = tb_display_line_attr(vp, line);
+  int length = strlen(text);
+  if(from >= length)
+    return;
+  if(to < 0 || to >= length-1){
+    text[from] = '\0';
+  } else {
+    for(int charpos = from; charpos <= to; charpos++){
+      text[charpos] = ' ';
+      attr[charpos] = TB_ATTR_DEFAULT;
+    }
+    tb_display_layout_line(vp, line, from);
+  }
+  tb_display_mark_dirty(vp, line, from);
+}
+
+// =============================================================
+// select the colors with the numbers of an SGR sequence (ESC [ ... m)
+// =============================================================
+static void tb_display_ansi_colors(tb_display_viewport *vp){
+  for(int n = 0; n <= vp->ansi_count; n++){
+    int param = vp->ansi_params[n];
+    int fg = vp->text_attr & 0x0F;
+    int bg = vp->text_attr >> 4;
+    if(param == 0){
+      fg = TB_ATTR_DEFAULT & 0x0F;
+      bg = TB_ATTR_DEFAULT >> 4;
+      vp->ansi_bold = false;
+    } else if(param == 1){
+      // bold text is shown with the bright colors
+      vp->ansi_bold = true;
+      if(fg < 8)
+        fg += 8;
+    } else if(param == 22){
+      vp->ansi_bold = false;
+      if(fg > 8 && fg < 15)
+        fg -= 8;
+    } else if(param >= 30 && param <= 37){
+      fg = param - 30 + (vp->ansi_bold ? 8 : 0);
+    } else if(param == 39){
+      fg = TB_ATTR_DEFAULT & 0x0F;
+    } else if(param >= 40 && param <= 47){
+      bg = param - 40;
+    } else if(param == 49){
+      bg = TB_ATTR_DEFAULT >> 4;
+    } else if(param >= 90 && param <= 97){
+      fg = param - 90 + 8;
+    } else if(param >= 100 && param <= 107){
+      bg = param - 100 + 8;
+    }
+    vp->text_attr = (bg << 4) | fg;
+  }
+}
+
+// =============================================================
+// execute an escape sequence ESC [ ... with the final character "data"
+// =============================================================
+static void tb_display_ansi_execute(tb_display_viewport *vp, byte data){
+  int row = tb_display_cursor_row(vp);
+  int column = vp->write_pointer_x;
+  // a missing number and 0 count as 1 for the cursor movements
+  int count = vp->ansi_params[0] > 0 ? vp->ansi_params[0] : 1;
+  switch(data){
+    case 'H': case 'f': {
+      int column_to = vp->ansi_count > 0 && vp->ansi_params[1] > 0 ? vp->ansi_params[1] : 1;
+      tb_display_cursor_to(vp, count-1, column_to-1);
+      break;
+    }
+    case 'A': {
+      tb_display_cursor_to(vp, row-count, column);
+      break;
+    }
+    case 'B': {
+      tb_display_cursor_to(vp, row+count, column);
+      break;
+    }
+    case 'C': {
+      tb_display_cursor_to(vp, row, column+count);
+      break;
+    }
+    case 'D': {
+      tb_display_cursor_to(vp, row, column-count);
+      break;
+    }
+    case 'K': case 'J': {
+      int mode = vp->ansi_params[0];
+      // the actual row
+      if(mode == 0)
+        tb_display_erase(vp, vp->write_pointer_y, column, -1);
+      else if(mode == 1)
+        tb_display_erase(vp, vp->write_pointer_y, 0, column);
+      else
+        tb_display_erase(vp, vp->write_pointer_y, 0, -1);
+      // the rows below or above the actual row
+      if(data == 'J'){
+        for(int n = 0; n < vp->rows; n++){
+          if((mode == 0 && n > row) || (mode == 1 && n < row) || (mode == 2 && n != row))
+            tb_display_erase(vp, (vp->read_pointer_y + n) % vp->rows, 0, -1);
+        }
+      }
+      // the write position stays in the same column
+      tb_display_cursor_to(vp, row, column);
+      break;
+    }
+    case 'm': {
+      tb_display_ansi_colors(vp);
+      break;
+    }
+    default: {
+      // not supported
+      break;
+    }
+  }
+  if(!vp->batch)
+    tb_display_changed(vp);
+}
+
+// =============================================================
+// a character of an escape sequence
+// ESC [ numbers separated by ; and a final character
+// =============================================================
+static void tb_display_ansi_char(tb_display_viewport *vp, byte data){
+  switch(vp->ansi_state){
+    case ANSI_NONE: {
+      // ESC: start of a sequence
+      vp->ansi_state = ANSI_ESC;
+      break;
+    }
+    case ANSI_ESC: {
+      if(data == '['){
+        vp->ansi_state = ANSI_CSI;
+        vp->ansi_count = 0;
+        vp->ansi_params[0] = 0;
+      } else {
+        // other sequences are not supported
+        vp->ansi_state = ANSI_NONE;
+      }
+      break;
+    }
+    case ANSI_CSI: {
+      if(data >= '0' && data <= '9'){
+        int param = vp->ansi_params[vp->ansi_count]*10 + (data - '0');
+        vp->ansi_params[vp->ansi_count] = param < 255 ? param : 255;
+      } else if(data == ';'){
+        // more numbers than supported are ignored
+        if(vp->ansi_count < (int)sizeof(vp->ansi_params)-1){
+          vp->ansi_count++;
+          vp->ansi_params[vp->ansi_count] = 0;
+        }
+      } else if(data >= 0x40 && data <= 0x7E){
+        vp->ansi_state = ANSI_NONE;
+        tb_display_ansi_execute(vp, data);
+      }
+      break;
+    }
+    default: {
+      vp->ansi_state = ANSI_NONE;
+      break;
+    }
+  }
+}
+
+// =============================================================
+// decode the UTF-8 bytes
+// The bytes of a character are collected in the viewport, so a
+// character can be split over several prints.
+// returns the extended character (tb_display_charset.h), '?' for
+// a character without a glyph or 0 if the character is not complete
+// =============================================================
+static byte tb_display_utf8_char(tb_display_viewport *vp, byte data){
+  if(data >= 0xC0){
+    // the first byte: the number of following bytes
+    // (a sequence that is not complete is dropped)
+    if(data < 0xE0){
+      vp->utf8_count = 1;
+      vp->utf8_code = data & 0x1F;
+    } else if(data < 0xF0){
+      vp->utf8_count = 2;
+      vp->utf8_code = data & 0x0F;
+    } else if(data < 0xF8){
+      vp->utf8_count = 3;
+      vp->utf8_code = data & 0x07;
+    } else {
+      vp->utf8_count = 0;
+    }
+    return 0;
+  }
+  // a following byte without a first byte is ignored
+  if(vp->utf8_count == 0)
+    return 0;
+  vp->utf8_code = (vp->utf8_code << 6) | (data & 0x3F);
+  vp->utf8_count--;
+  if(vp->utf8_count > 0)
+    return 0;
+  // the control characters 128 - 159 are not printed
+  if(vp->utf8_code >= 0x80 && vp->utf8_code < 0xA0)
+    return 0;
+  byte code = tb_display_charset_code(vp->utf8_code);
+  return code != 0 ? code : '?';
 }
 
 // =============================================================
@@ -205,81 +1380,92 @@ void tb_display_new_line(){
 // example: 
 //    tb_display_print_char('X');
 // =============================================================
-void tb_display_print_char(byte data){
+void tb_display_viewport_print_char(tb_display_viewport *vp, byte data){
+  TB_STATS_TIME(char_time);
+  // UTF-8: the bytes from 128 are parts of a character
+  // (without UTF-8, they are the extended characters themselves)
+  if(tb_display_utf8){
+    if(data > 127){
+      data = tb_display_utf8_char(vp, data);
+      if(data == 0)
+        return;
+    } else {
+      vp->utf8_count = 0;
+    }
+  }
+  // escape sequences
+  if(tb_display_ansi && (vp->ansi_state != ANSI_NONE || data == ANSI_ESC_CHAR)){
+    tb_display_ansi_char(vp, data);
+    return;
+  }
+  // CR: back to the start of the row
+  if(tb_display_ansi && data == '\r'){
+    vp->write_pointer_x = 0;
+    vp->cursor_x = SCREEN_XSTARTPOS;
+    return;
+  }
   // check for LF for new line
+  // (the text of a line always ends with a null terminator)
   if (data == '\n') {
-    // last character in the text_buffer line  should be always a null terminator
-    text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = '\0';
-    tb_display_new_line();
+    tb_display_viewport_new_line(vp);
   }
   // only 'printable' characters
-  if (data > 31 && data < 128) {
-    // print the character and get the new xpos
-    screen_xpos += M5.Lcd.drawChar(data,screen_xpos,screen_ypos,TEXT_SIZE);
-    // if maximum number of characters reached
-    if(text_buffer_write_pointer_x >= text_buffer_line_length-1){
-      tb_display_new_line();
-      // draw the character again because it was out of the screen last time
-      screen_xpos += M5.Lcd.drawChar(data,screen_xpos,screen_ypos,TEXT_SIZE);
-    }
-    // or if line wrap is reached
-    if(screen_xpos >= screen_max) {
-      // prepare for Word-Wrap stuff...
-      // the buffer for storing the last word content
-      char Char_buffer[TEXT_BUFFER_LINE_LENGTH_WIDE];
-      int n = 1;
-      Char_buffer[0] = data;
-      Char_buffer[n] = '\0';
-      // if Word-Wrap, go backwards and get the last "word" by finding the
-      // last space character:
-      if(tb_display_word_wrap){
-        int test_pos = text_buffer_write_pointer_x-1;
-        // get backwards and search a space character
-        while(test_pos > 0 && text_buffer[text_buffer_write_pointer_y][test_pos] != ' '){
-          // store all the characters on the way back to the last space character
-          Char_buffer[n] = text_buffer[text_buffer_write_pointer_y][test_pos];
-          test_pos--;
-          n++;
-          Char_buffer[n] = '\0';
-        }
-        // if there was no space character in the row, Word-Wrap is not possible
-        if(test_pos == 0) {
-          // don't use the buffer but draw the character passed to the function
-          n = 1;
-        } else {
-          // otherwise use the buffer to print the last found characters of the word
-          // but only, if the charachter that causes a word wrap is not a space character
-          if(data != ' '){
-            // place a \0 at the position of the found space so that the drawing fuction ends here
-            text_buffer[text_buffer_write_pointer_y][test_pos] = '\0';
+  // (ASCII and the extended characters)
+  if (data > 31) {
+    int line = vp->write_pointer_y;
+    char *text = tb_display_line_text(vp, line);
+    int space_pos;
+    switch(tb_display_layout_char(vp, text, vp->write_pointer_x,
+                                  vp->cursor_x, data, &space_pos)){
+      case TB_LAYOUT_APPEND: {
+        tb_display_put_char(vp, data, vp->text_attr);
+        break;
+      }
+      case TB_LAYOUT_NEW_LINE: {
+        tb_display_next_row(vp, TB_ROW_WRAP);
+        tb_display_put_char(vp, data, vp->text_attr);
+        break;
+      }
+      case TB_LAYOUT_WRAP: {
+        // the buffer for storing the last word content and its colors
+        // (a row of a viewport has less than 255 characters)
+        char Char_buffer[255];
+        uint8_t Attr_buffer[255];
+        uint8_t *attr = tb_display_line_attr(vp, line);
+        int n = 0;
+        if(space_pos > 0){
+          for(int charpos = space_pos+1; charpos < vp->write_pointer_x; charpos++){
+            Attr_buffer[n] = attr[charpos];
+            Char_buffer[n++] = text[charpos];
           }
+          // place a \0 at the position of the found space so that the row ends here
+          text[space_pos] = '\0';
+          tb_display_mark_dirty(vp, line, space_pos);
+          TB_STATS_ADD(wrap_backtracks, 1);
+          TB_STATS_ADD(wrap_moved, n);
         }
+        // the space in front of the moved word or a space character
+        // at the end of the row is removed
+        tb_display_next_row(vp, space_pos > 0 || data == ' ' ? TB_ROW_SPACE : TB_ROW_WRAP);
+        // write the last word into the new line
+        for(int charpos = 0; charpos < n; charpos++)
+          tb_display_put_char(vp, Char_buffer[charpos], Attr_buffer[charpos]);
+        // if the character passed to the function is a space character,
+        // then don't display it as the first character of the new line
+        if(data != ' ')
+          tb_display_put_char(vp, data, vp->text_attr);
+        break;
       }
-      tb_display_new_line();
-      // icharacter passed to the function is a space character, then don't display
-      // it as the first character of the new line
-      if(data == ' ') 
-        // don't use the buffer at all
-        n = 0;
-      n--;
-      while(n >= 0){
-        // draw the characters from the buffer back on the screen
-        screen_xpos += M5.Lcd.drawChar(Char_buffer[n],screen_xpos,screen_ypos,TEXT_SIZE);
-        // write the characters into the screen buffer of the new line
-        text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = Char_buffer[n];
-        text_buffer_write_pointer_x++;
-        n--;
+      default: {
+        break;
       }
-      text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = '\0';
-    } else {
-      // write the character into the screen buffer
-      text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = data;
-      text_buffer_write_pointer_x++;
-      // following character a null terminator to clear the old characters of the line
-      text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = '\0';
     }
   }
-  }
+}
+
+void tb_display_print_char(byte data){
+  tb_display_viewport_print_char(&tb_screen, data);
+}
 
 // =============================================================
 // print a string
@@ -302,12 +1488,88 @@ void tb_display_print_char(byte data){
 //    const char * c_msg = msg.c_str();
 //    tb_display_print_String(c_msg);
 // =============================================================
-void tb_display_print_String(const char *s, int chr_delay){
-  while(*s != 0){
-    tb_display_print_char(*s++);
-    if(chr_delay > 0)
+void tb_display_viewport_print_String(tb_display_viewport *vp, const char *s, int chr_delay){
+  if(chr_delay > 0){
+    while(*s != 0){
+      tb_display_viewport_print_char(vp, *s++);
+      tb_display_viewport_update(vp);
       delay(chr_delay);
+    }
+  } else {
+    tb_display_viewport_print_bytes(vp, (const uint8_t*)s, strlen(s));
+  }
+}
+
+void tb_display_print_String(const char *s, int chr_delay){
+  tb_display_viewport_print_String(&tb_screen, s, chr_delay);
+}
+
+// =============================================================
+// print a block of characters
+// lay out all characters in the text buffer first
+// and draw only the final screen
+// =============================================================
+void tb_display_viewport_print_bytes(tb_display_viewport *vp, const uint8_t *data, size_t length){
+  // inside of a batch, the end of the batch draws the screen
+  bool batch = vp->batch;
+  vp->batch = true;
+  for(size_t n = 0; n < length; n++)
+    tb_display_viewport_print_char(vp, data[n]);
+  vp->batch = batch;
+  if(!batch)
+    tb_display_changed(vp);
+}
+
+void tb_display_print_bytes(const uint8_t *data, size_t length){
+  tb_display_viewport_print_bytes(&tb_screen, data, length);
+}
+
+// =============================================================
+// several prints are drawn at once
+// =============================================================
+void tb_display_viewport_batch_begin(tb_display_viewport *vp){
+  vp->batch = true;
+}
+
+void tb_display_viewport_batch_end(tb_display_viewport *vp){
+  vp->batch = false;
+  tb_display_changed(vp);
+}
+
+void tb_display_batch_begin(){
+  tb_display_viewport_batch_begin(&tb_screen);
+}
+
+void tb_display_batch_end(){
+  tb_display_viewport_batch_end(&tb_screen);
+}
+
+// =============================================================
+// fill the top row after the display scrolled down
+// The last row of the history is taken back, unless the row that
+// scrolled out was one of the empty rows of a new screen.
+// =============================================================
+static void tb_display_restore_top_row(tb_display_viewport *vp){
+  int top = vp->read_pointer_y;
+  char *text = tb_display_line_text(vp, top);
+  uint8_t *attr = tb_display_line_attr(vp, top);
+  int length = 0;
+  if(vp->history && vp->blank_rows == 0 && tb_display_scrollback_count() > 0){
+    int n = tb_display_scrollback_count() - 1;
+    const char *row = tb_display_scrollback_row(n);
+    while(length < vp->line_length-1 && row[length] != '\0'){
+      text[length] = row[length];
+      attr[length++] = TB_ATTR_DEFAULT;
+    }
+    vp->row_end[top] = tb_display_scrollback_row_end(n);
+    tb_display_scrollback_pop();
+  } else {
+    vp->row_end[top] = TB_ROW_END;
+    vp->blank_rows++;
   }
+  text[length] = '\0';
+  tb_display_line_xpos(vp, top)[0] = SCREEN_XSTARTPOS;
+  tb_display_layout_line(vp, top, 0);
 }
 
 // =============================================================
@@ -316,23 +1578,366 @@ void tb_display_print_String(const char *s, int chr_delay){
 // If the first character of a row is deleted, the display scrolls
 // automatically down
 // =============================================================
-void tb_display_delete_char(){
-  if(text_buffer_write_pointer_x > 0){
+void tb_display_viewport_delete_char(tb_display_viewport *vp){
+  // show the actual rows again
+  tb_display_viewport_scroll_back(vp, -vp->scrollback_view);
+  if(vp->write_pointer_x > 0){
     // go one character to the left
-    text_buffer_write_pointer_x--;
-    // replace the character with \0
-    text_buffer[text_buffer_write_pointer_y][text_buffer_write_pointer_x] = '\0';
+    vp->write_pointer_x--;
+    // remove the character
+    // (the following characters move to the left)
+    char *text = tb_display_line_text(vp, vp->write_pointer_y);
+    uint8_t *attr = tb_display_line_attr(vp, vp->write_pointer_y);
+    for(int charpos = vp->write_pointer_x; text[charpos] != '\0'; charpos++){
+      text[charpos] = text[charpos+1];
+      attr[charpos] = attr[charpos+1];
+    }
+    tb_display_layout_line(vp, vp->write_pointer_y, vp->write_pointer_x);
+    tb_display_mark_dirty(vp, vp->write_pointer_y, vp->write_pointer_x);
+    vp->cursor_x = tb_display_line_xpos(vp, vp->write_pointer_y)[vp->write_pointer_x];
+  } else if(vp->write_pointer_y != tb_display_last_line(vp)){
+    // the write position was moved up with an escape sequence:
+    // continue at the end of the row above without scrolling
+    if(vp->write_pointer_y == vp->read_pointer_y)
+      return;
+    vp->write_pointer_y = (vp->write_pointer_y + vp->rows - 1) % vp->rows;
+    vp->write_pointer_x = strlen(tb_display_line_text(vp, vp->write_pointer_y));
+    vp->cursor_x = tb_display_line_xpos(vp, vp->write_pointer_y)[vp->write_pointer_x];
+    return;
   } else {
     // scroll the display one row down
-    text_buffer_write_pointer_y--;
-    text_buffer_read_pointer_y--;
+    vp->write_pointer_y--;
+    vp->read_pointer_y--;
     // circular buffer...
-    if(text_buffer_write_pointer_y < 0)
-      text_buffer_write_pointer_y = text_buffer_height - 1;
-    if(text_buffer_read_pointer_y < 0)
-      text_buffer_read_pointer_y = text_buffer_height - 1;
+    if(vp->write_pointer_y < 0)
+      vp->write_pointer_y = vp->rows - 1;
+    if(vp->read_pointer_y < 0)
+      vp->read_pointer_y = vp->rows - 1;
+    // all rows moved one row down on the screen
+    tb_display_mark_all_dirty(vp);
+    // the row that scrolled out at the top comes back
+    tb_display_restore_top_row(vp);
+    // continue writing at the end of the row
+    char *text = tb_display_line_text(vp, vp->write_pointer_y);
+    int charpos = 0;
+    while(charpos < vp->line_length-1 && text[charpos] != '\0')
+      charpos++;
+    vp->write_pointer_x = charpos;
+    vp->cursor_x = tb_display_line_xpos(vp, vp->write_pointer_y)[charpos];
   }
-  // refresh the full display
-  tb_display_show();
+  // redraw the changed part of the display
+  tb_display_changed(vp);
+}
+
+void tb_display_delete_char(){
+  tb_display_viewport_delete_char(&tb_screen);
+}
+
+// =============================================================
+// limit the frame rate of the screen
+// fps = maximum number of frames per second (0 = not limited)
+// max_latency = maximum time in milliseconds from the first change
+// to the frame (0 = only the frame rate counts)
+// =============================================================
+void tb_display_set_frame_rate(int fps, int max_latency){
+  if(fps > 0){
+    frame_interval = 1000/fps;
+    if(frame_interval == 0)
+      frame_interval = 1;
+  } else {
+    frame_interval = 0;
+  }
+  frame_latency = max_latency > 0 ? max_latency : 0;
+  // draw the changes that are waiting
+  if(frame_interval == 0 && tb_screen.changed)
+    tb_display_refresh();
+}
+
+// =============================================================
+// draw the changes of the text buffer
+// if the time for the next frame is reached
+// or the first change waits for max_latency
+// =============================================================
+bool tb_display_viewport_update(tb_display_viewport *vp){
+  if(!vp->changed)
+    return false;
+  unsigned long now = millis();
+  bool frame_time = now - vp->frame_last >= frame_interval;
+  bool latency_time = frame_latency > 0 && now - vp->changed_time >= frame_latency;
+  if(!frame_time && !latency_time)
+    return false;
+  vp->frame_last = now;
+  tb_display_viewport_refresh(vp);
+  return true;
+}
+
+bool tb_display_update(){
+  return tb_display_viewport_update(&tb_screen);
 }
 
+// =============================================================
+// the line editor
+// The line is kept here and drawn into the text buffer of the
+// screen from its start position after every key.
+// =============================================================
+// the characters of the line and the position of the cursor
+static char edit_line[TB_DISPLAY_EDIT_LENGTH+1];
+static int edit_length = 0;
+static int edit_cursor = 0;
+static bool edit_line_active = false;
+// the start of the line: row on the screen and character position
+static int edit_row = 0;
+static int edit_column = 0;
+// the write position behind the line after the last drawing
+static int edit_end_y = 0;
+static int edit_end_x = 0;
+
+// =============================================================
+// number of rows needed for the first "length" characters of
+// the line and the cursor behind them
+// (the same layout as tb_display_edit_put)
+// =============================================================
+static int tb_display_edit_rows(tb_display_viewport *vp, int length){
+  int line = (vp->read_pointer_y + edit_row) % vp->rows;
+  int charpos = edit_column;
+  int xpos = tb_display_line_xpos(vp, line)[edit_column];
+  int rows = 1;
+  for(int n = 0; n <= length; n++){
+    int width = tb_display_char_width(n < length ? edit_line[n] : ' ');
+    if(charpos >= vp->line_length-1 || xpos + width >= vp->max_x){
+      rows++;
+      charpos = 0;
+      xpos = SCREEN_XSTARTPOS;
+    }
+    charpos++;
+    xpos += width;
+  }
+  return rows;
+}
+
+// =============================================================
+// the line starts at the actual write position
+// If other text was printed behind the line, the line starts
+// again in the next row.
+// =============================================================
+static void tb_display_edit_place(tb_display_viewport *vp){
+  if(vp->write_pointer_y == edit_end_y && vp->write_pointer_x == edit_end_x)
+    return;
+  if(vp->write_pointer_x > 0)
+    tb_display_viewport_new_line(vp);
+  edit_row = tb_display_cursor_row(vp);
+  edit_column = vp->write_pointer_x;
+  edit_end_y = vp->write_pointer_y;
+  edit_end_x = vp->write_pointer_x;
+}
+
+// =============================================================
+// add a character of the line at the write position
+// The line is wrapped at the last character that fits into the
+// row (no Word-Wrap), so the start of the line never moves.
+// =============================================================
+static void tb_display_edit_put(tb_display_viewport *vp, byte data, uint8_t attr){
+  int space_pos;
+  if(tb_display_layout_char(vp, tb_display_line_text(vp, vp->write_pointer_y),
+                            vp->write_pointer_x, vp->cursor_x, data, &space_pos) != TB_LAYOUT_APPEND)
+    tb_display_next_row(vp, TB_ROW_WRAP);
+  tb_display_put_char(vp, data, attr);
+}
+
+// =============================================================
+// write the line into the text buffer and draw the changes
+// The rows of the line are erased and written again, but only
+// the characters that differ from the screen are drawn: a moved
+// cursor draws two characters, a shorter line erases the rest.
+// cursor = false: the line without the cursor
+// =============================================================
+static void tb_display_edit_render(tb_display_viewport *vp, bool cursor){
+  // show the actual rows again
+  tb_display_viewport_scroll_back(vp, -vp->scrollback_view);
+  vp->batch = true;
+  tb_display_cursor_to(vp, edit_row, edit_column);
+  tb_display_erase(vp, vp->write_pointer_y, vp->write_pointer_x, -1);
+  for(int row = edit_row+1; row < vp->rows; row++)
+    tb_display_erase(vp, (vp->read_pointer_y + row) % vp->rows, 0, -1);
+  int read_pointer = vp->read_pointer_y;
+  for(int n = 0; n < edit_length; n++)
+    tb_display_edit_put(vp, edit_line[n], cursor && n == edit_cursor ? TB_ATTR_CURSOR : vp->text_attr);
+  if(cursor && edit_cursor == edit_length)
+    tb_display_edit_put(vp, ' ', TB_ATTR_CURSOR);
+  // the start of the line moves up with the scrolled rows
+  edit_row -= (vp->read_pointer_y - read_pointer + vp->rows) % vp->rows;
+  if(edit_row < 0)
+    edit_row = 0;
+  vp->batch = false;
+  edit_end_y = vp->write_pointer_y;
+  edit_end_x = vp->write_pointer_x;
+  tb_display_changed(vp);
+}
+
+// =============================================================
+// start a new line at the actual write position
+// =============================================================
+void tb_display_edit_begin(){
+  tb_display_viewport *vp = &tb_screen;
+  tb_display_viewport_scroll_back(vp, -vp->scrollback_view);
+  edit_length = 0;
+  edit_cursor = 0;
+  edit_line[0] = '\0';
+  edit_line_active = true;
+  edit_row = tb_display_cursor_row(vp);
+  edit_column = vp->write_pointer_x;
+  edit_end_y = vp->write_pointer_y;
+  edit_end_x = vp->write_pointer_x;
+  tb_display_edit_render(vp, true);
+}
+
+// =============================================================
+// edit the line with a key
+// returns true if the line is completed with Enter
+// =============================================================
+bool tb_display_edit_key(uint8_t key){
+  tb_display_viewport *vp = &tb_screen;
+  if(!edit_line_active)
+    tb_display_edit_begin();
+  tb_display_edit_place(vp);
+  if(key == '\r' || key == '\n'){
+    // the line without the cursor stays on the screen
+    tb_display_edit_render(vp, false);
+    tb_display_viewport_new_line(vp);
+    edit_line_active = false;
+    return true;
+  }
+  if(key == 8){
+    // remove the character in front of the cursor
+    if(edit_cursor > 0){
+      edit_cursor--;
+      memmove(edit_line+edit_cursor, edit_line+edit_cursor+1, edit_length-edit_cursor);
+      edit_length--;
+    }
+  } else if(key == 127){
+    // remove the character at the cursor
+    if(edit_cursor < edit_length){
+      memmove(edit_line+edit_cursor, edit_line+edit_cursor+1, edit_length-edit_cursor);
+      edit_length--;
+    }
+  } else if(key == TB_KEY_LEFT){
+    if(edit_cursor > 0)
+      edit_cursor--;
+  } else if(key == TB_KEY_RIGHT){
+    if(edit_cursor < edit_length)
+      edit_cursor++;
+  } else if(key > 31 && key < 127 && edit_length < TB_DISPLAY_EDIT_LENGTH){
+    // insert the character at the cursor
+    // The line has to fit on the screen, otherwise its start
+    // would scroll out of the screen.
+    memmove(edit_line+edit_cursor+1, edit_line+edit_cursor, edit_length-edit_cursor+1);
+    edit_line[edit_cursor] = key;
+    edit_length++;
+    if(tb_display_edit_rows(vp, edit_length) > vp->rows){
+      memmove(edit_line+edit_cursor, edit_line+edit_cursor+1, edit_length-edit_cursor);
+      edit_length--;
+    } else {
+      edit_cursor++;
+    }
+  }
+  // other keys are ignored
+  tb_display_edit_render(vp, true);
+  return false;
+}
+
+// =============================================================
+// the characters of the edited line
+// =============================================================
+const char *tb_display_edit_line(){
+  return edit_line;
+}
+
+// =============================================================
+// a line is edited (started and not completed with Enter)
+// =============================================================
+bool tb_display_edit_active(){
+  return edit_line_active;
+}
+
+// =============================================================
+// define a status field
+// =============================================================
+bool tb_display_status_field(int n, int row, int x, int width){
+  // the x positions in the field are stored in bytes
+  if(n < 0 || n >= TB_DISPLAY_STATUS_FIELDS || width <= SCREEN_XSTARTPOS || width > 255)
+    return false;
+  tb_display_status *field = &status_fields[n];
+  tb_display_viewport *vp = &field->vp;
+  // erase the old field
+  if(tb_display_status_visible(field)){
+    tb_backend->fill_rect(vp->x, vp->y, vp->width, vp->row_height, TFT_BLACK);
+    TB_STATS_ADD(pixels, vp->width*vp->row_height);
+  }
+  field->memory.attach(vp);
+  vp->x = x;
+  vp->y = row*TEXT_HEIGHT;
+  vp->width = width;
+  vp->row_height = TEXT_HEIGHT;
+  vp->max_x = width - SCREEN_XMARGIN;
+  vp->hw_scroll_active = false;
+  vp->history = false;
+  vp->batch = false;
+  vp->changed = false;
+  vp->utf8_count = 0;
+  vp->text[0] = '\0';
+  vp->screen_length[0] = 0;
+  vp->screen_xpos[0] = SCREEN_XSTARTPOS;
+  field->used = true;
+  field->attr = TB_ATTR_DEFAULT;
+  return true;
+}
+
+// =============================================================
+// show a value in a status field
+// =============================================================
+void tb_display_status_set(int n, const char *value){
+  if(n < 0 || n >= TB_DISPLAY_STATUS_FIELDS || !status_fields[n].used)
+    return;
+  tb_display_status *field = &status_fields[n];
+  tb_display_viewport *vp = &field->vp;
+  // the characters that fit into the field
+  int length = 0;
+  int xpos = SCREEN_XSTARTPOS;
+  vp->utf8_count = 0;
+  for(; *value != '\0' && length < vp->line_length-1; value++){
+    byte data = *value;
+    if(data > 127 && tb_display_utf8){
+      data = tb_display_utf8_char(vp, data);
+      if(data == 0)
+        continue;
+    } else if(data < 32 || data == 127){
+      continue;
+    }
+    // the same limit as for the rows of the scrolling text
+    // (tb_display_layout_char)
+    int width = tb_display_char_width(data);
+    if(xpos + width >= vp->max_x)
+      break;
+    xpos += width;
+    vp->text[length] = data;
+    vp->attr[length++] = field->attr;
+  }
+  vp->text[length] = '\0';
+  // only the changed characters are drawn
+  if(tb_display_status_visible(field))
+    tb_display_draw_row(vp, 0, vp->text, vp->attr, 0);
+}
+
+// =============================================================
+// the colors of a status field
+// =============================================================
+void tb_display_status_color(int n, uint8_t attr){
+  if(n < 0 || n >= TB_DISPLAY_STATUS_FIELDS || !status_fields[n].used)
+    return;
+  tb_display_status *field = &status_fields[n];
+  field->attr = attr;
+  for(int charpos = 0; field->vp.text[charpos] != '\0'; charpos++)
+    field->vp.attr[charpos] = attr;
+  if(tb_display_status_visible(field))
+    tb_display_draw_row(&field->vp, 0, field->vp.text, field->vp.attr, 0);
+}
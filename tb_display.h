@@ -23,12 +23,125 @@
  *        - screen_xpos and text_buffer_write_pointer_x set in display_show function
  * v1.5 = - Bugfix if the character that causes a word wrap is a space character
  * v1.6 = Added case differentiation between M5StcikC und M5StickCPlus
+ * v1.7 = - Drawing through exchangeable display backends
+ *          (M5StickC, M5StickCPlus and RGB565 framebuffer)
+ * v1.8 = - Optional hardware scroll of the LCD controller for a new line
+ * v1.9 = - Only changed rows and characters are redrawn
+ * v1.10 = - Optional row sprite mode: characters are drawn off-screen
+ *           and pushed with one transfer
+ * v1.11 = - tb_display_print_String draws the screen only once
+ * v1.12 = - Line wrap and Word-Wrap are calculated with the character
+ *           widths before anything is drawn
+ * v1.13 = - Scrollback history with page up and page down
+ * v1.14 = - Lock-free input queue and render task on the second core
+ * v1.15 = - Typewriter effect without delay() driven by a millis() tick
+ * v1.16 = - Optional limited frame rate: changes are drawn by tb_display_update()
+ * v1.17 = - The state of the text buffer is kept in a viewport
+ *         - Several scrolling viewports can share the screen (TB_TextBuffer)
+ *         - Landscape and portrait mode share the text buffer memory
+ * v1.18 = - ANSI/VT100 escape sequences for the cursor position, erasing
+ *           and colors (per character)
+ * v1.19 = - Glyph cache: the characters are rendered once per color and
+ *           copied to the screen
+ * v1.20 = - Counters and timing histograms of the drawing (tb_display_stats.h)
+ * v1.21 = - tb_display_print_bytes for blocks of received bytes
+ * v1.22 = - Keyboard-Hat polling with an interval that adapts to the typing
+ *           (tb_display_keyboard.h)
+ * v1.23 = - Line editor with a cursor, insert and delete inside the line
+ *         - Only the changed part of a row is drawn again
+ * v1.24 = - tb_display_set_rotation keeps the text: the logical lines are
+ *           wrapped again for the new rotation
+ * v1.25 = - UTF-8 text: Latin-1 characters and symbols with an extended
+ *           font (tb_display_charset.h)
+ * v1.26 = - Benchmark with a counting LCD stub and golden frames
+ *           (tb_display_bench.h)
+ * v1.27 = - Mirror of the display over the serial port: only the changed
+ *           rows are sent (tb_display_mirror.h)
+ * v1.28 = - Pinned status fields above the scrolling text: only the
+ *           changed characters of a field are drawn
+ * v1.29 = - Arduino Print interface: TBDisplay.print(), println() and
+ *           printf() (tb_display_print.h)
+ *         - tb_display_batch_begin/end: several prints are drawn once
+ * v1.30 = - Snapshot of the screen rows in the RTC memory: tb_display_init
+ *           restores the display after the deep sleep (tb_display_snapshot.h)
+ *         - tb_display_set_backend sets the default colors of the new backend
  * 
  * 
  * Distributed as-is; no warranty is given.
  ******************************************************************************/
 
 
+// =============================================================
+// Enable or disable Word Wrap (default: enabled)
+// =============================================================
+extern boolean tb_display_word_wrap;
+
+// =============================================================
+// Enable or disable the UTF-8 decoding (default: enabled)
+// The printed text is UTF-8. The Latin-1 characters (° µ ² ä ö ü
+// ß é ...) and some symbols (€ Ω ← ↑ → ↓ • … ™ ...) are shown
+// with an extended font, other characters are shown as '?'.
+// A character can be split over several prints.
+// Disabled: the bytes 128 - 255 are the extended characters
+// themselves (Latin-1 / Windows-1252, see tb_display_charset.h).
+// example:
+//    tb_display_print_String("Temp: 23.5°C\n");
+// =============================================================
+extern boolean tb_display_utf8;
+
+// =============================================================
+// Enable or disable the escape sequences (default: disabled)
+// The printed text can contain ANSI/VT100 escape sequences:
+//    ESC [ row ; column H    move to the row and column (from 1)
+//    ESC [ n A / B / C / D   move n rows up / down, n characters
+//                            right / left
+//    ESC [ n K               erase the row: 0 = behind, 1 = in front of
+//                            the write position, 2 = the whole row
+//    ESC [ n J               the same for the screen
+//    ESC [ n ; ... m         colors: 0 = default, 1 = bright,
+//                            30-37 / 90-97 = text color,
+//                            40-47 / 100-107 = background color
+// CR goes back to the start of the row, the new characters replace
+// the old ones. The scrollback history keeps the text without colors.
+// Other sequences are ignored.
+// example:
+//    tb_display_ansi = true;
+//    tb_display_print_String("\x1b[31mred\x1b[0m and white\n");
+// =============================================================
+extern boolean tb_display_ansi;
+
+// =============================================================
+// Enable or disable the hardware scroll (default: disabled)
+// Instead of a redraw of the whole screen, the LCD controller
+// moves the screen content one row up and only the new row
+// is drawn. Only possible in portrait mode (rotation 2 and 4).
+// In landscape mode, the screen is redrawn as before.
+// Set before calling tb_display_init()
+// =============================================================
+extern boolean tb_display_hw_scroll;
+
+// =============================================================
+// Enable or disable the row sprite mode (default: disabled)
+// The characters of a row are drawn in an off-screen sprite and
+// the sprite is pushed with one transfer to the screen, instead
+// of one transfer for each character.
+// The memory of the sprite is set with TB_DISPLAY_SPRITE_BUDGET
+// in tb_display_config.h. With less memory than a full row, the
+// rows are pushed in several parts.
+// Set before calling tb_display_init()
+// =============================================================
+extern boolean tb_display_row_sprite;
+
+// =============================================================
+// Rows at the top of the screen for status fields (default: 0)
+// The scrolling text uses the rows below, the status fields are
+// never scrolled (see tb_display_status_field). At least one row
+// stays for the scrolling text. The hardware scroll is not possible
+// with status rows.
+// Set before calling tb_display_init() or tb_display_set_rotation()
+// =============================================================
+extern int tb_display_status_rows;
+
 // =============================================================
 //           tb_display_init(int ScreenRotation);
 // Initialization of the Text Buffer and Screen
@@ -41,15 +154,46 @@
 // With TEXT_HEIGHT=16, the screen can display:
 //    5 rows of text in landscape mode
 //   10 rows of text in portrait mode
+// After a deep sleep, the first call shows the rows saved with
+// tb_display_snapshot_save() again instead of an empty screen (see
+// tb_display_snapshot.h).
 // =============================================================
 void tb_display_init(int ScreenRotation);
 
+// =============================================================
+//           tb_display_set_rotation(int ScreenRotation);
+// change the rotation of the screen and keep the text
+// (the ScreenRotation values of tb_display_init)
+// The text buffer knows which rows were wrapped. The wrapped rows
+// are joined to the logical lines again and only the lines that
+// are visible with the new rotation are wrapped again. The screen
+// is drawn once. The rows that do not fit onto the screen anymore
+// go into the scrollback history. With more rows on the screen,
+// the last lines of the history are shown as well.
+// The rows that were already in the history keep the width of
+// the old rotation (longer rows are cut off on the screen).
+// tb_display_init() must be called once before.
+// example:
+//    tb_display_init(3);
+//    ...
+//    tb_display_set_rotation(2);
+// =============================================================
+void tb_display_set_rotation(int ScreenRotation);
+
 // =============================================================
 //           tb_display_show();
 // clear the screen and display the text buffer
 // =============================================================
 void tb_display_show();
 
+// =============================================================
+//           tb_display_refresh();
+// redraw only the changed part of the screen
+// Only the characters of the text buffer that differ from the
+// characters on the screen are erased and drawn again.
+// =============================================================
+void tb_display_refresh();
+
 // =============================================================
 //           tb_display_clear();
 // clear the text buffer
@@ -69,9 +213,15 @@ void tb_display_new_line();
 // print a string
 // The string is added to the text buffer and directly printed
 // on the screen.
+// The whole string is added to the text buffer first and the
+// screen is drawn only once afterwards. Lines that scroll out of
+// the screen within the string are never drawn.
 // The optional parameter "chr_delay" allows a "character by character"
 // processing of the String. Then, it looks like Teletype or Typewriter
 // The delay is in milliseconds.
+// Note: with a delay, the function returns after the last character.
+// tb_display_type_String() (tb_display_typewriter.h) types the
+// string without stopping the loop().
 // The text is automatically wrapped if longer than the display
 // example: 
 //    tb_display_print_String("a new line\n");
@@ -88,6 +238,38 @@ void tb_display_new_line();
 // =============================================================
 void tb_display_print_String(const char *s, int chr_delay = 0);
 
+// =============================================================
+//           tb_display_print_bytes(const uint8_t *data, size_t length);
+// print a block of characters
+// Like tb_display_print_String, but for a block of received bytes
+// without a null terminator: all characters are added to the text
+// buffer and the screen is drawn only once afterwards.
+// Characters that are not printable are ignored (like with
+// tb_display_print_char).
+// example:
+//    uint8_t buffer[256];
+//    size_t length = Serial.readBytes(buffer, sizeof(buffer));
+//    tb_display_print_bytes(buffer, length);
+// =============================================================
+void tb_display_print_bytes(const uint8_t *data, size_t length);
+
+// =============================================================
+//           tb_display_batch_begin();
+//           tb_display_batch_end();
+// print several times and draw the screen only once
+// Between begin and end, the print functions only change the
+// text buffer. tb_display_batch_end() draws the changes (with a
+// limited frame rate: the next tb_display_update()).
+// example:
+//    tb_display_batch_begin();
+//    TBDisplay.print("T=");
+//    TBDisplay.print(temperature, 1);
+//    TBDisplay.println(" C");
+//    tb_display_batch_end();
+// =============================================================
+void tb_display_batch_begin();
+void tb_display_batch_end();
+
 // =============================================================
 //           tb_display_print_char(byte data);
 // print a single character
@@ -108,3 +290,155 @@ void tb_display_print_char(byte data);
 // automatically down
 // =============================================================
 void tb_display_delete_char();
+
+// =============================================================
+// keys of the line editor (Keyboard-Hat codes)
+// =============================================================
+#define TB_KEY_LEFT  0xB4
+#define TB_KEY_RIGHT 0xB7
+
+// =============================================================
+//           tb_display_edit_key(uint8_t key);
+// edit a line at the write position with a visible cursor
+// The first key starts a new line (see tb_display_edit_begin).
+// Printable characters are inserted at the cursor,
+// TB_KEY_LEFT / TB_KEY_RIGHT move the cursor inside the line,
+// backspace (8) removes the character in front of the cursor,
+// delete (127) the character at the cursor.
+// The line is wrapped at the end of the row (no Word-Wrap) and
+// the rows become shorter again when characters are removed.
+// Only the changed characters are drawn.
+// Enter ('\r' or '\n') completes the line: the cursor is removed
+// and the write position is moved to the next row.
+// The line has at most TB_DISPLAY_EDIT_LENGTH characters
+// (tb_display_config.h) and must fit on the screen.
+// If other text is printed while a line is edited, the line
+// continues in the row below that text.
+// returns true if the line is completed
+// example:
+//    if(tb_display_edit_key(key))
+//      Serial.println(tb_display_edit_line());
+// =============================================================
+bool tb_display_edit_key(uint8_t key);
+
+// =============================================================
+//           tb_display_edit_begin();
+// start a new empty line at the write position
+// =============================================================
+void tb_display_edit_begin();
+
+// =============================================================
+//           tb_display_edit_line();
+// returns the characters of the edited (or completed) line
+// =============================================================
+const char *tb_display_edit_line();
+
+// =============================================================
+//           tb_display_edit_active();
+// returns true if a line is edited and not completed yet
+// =============================================================
+bool tb_display_edit_active();
+
+// =============================================================
+//           tb_display_scroll_back(int rows);
+// scroll the screen back into the history
+// rows > 0 = show older rows
+// rows < 0 = show newer rows
+// The rows are taken from the scrollback history. Its size is
+// set in tb_display_config.h (TB_DISPLAY_SCROLLBACK_LINES and
+// TB_DISPLAY_SCROLLBACK_BYTES).
+// While the history is shown, new text is added to the text
+// buffer, but the screen stays at the shown rows.
+// tb_display_delete_char() shows the actual rows again.
+// example:
+//    tb_display_scroll_back(-tb_display_scroll_position());
+//    shows the actual rows again
+// =============================================================
+void tb_display_scroll_back(int rows);
+
+// =============================================================
+//           tb_display_page_up();
+//           tb_display_page_down();
+// scroll one page back or forward in the history
+// one row of the old page stays on the screen
+// =============================================================
+void tb_display_page_up();
+void tb_display_page_down();
+
+// =============================================================
+//           tb_display_scroll_position();
+// returns the number of rows the screen is scrolled back
+// 0 = the actual rows are shown
+// =============================================================
+int tb_display_scroll_position();
+
+// =============================================================
+//           tb_display_set_frame_rate(int fps, int max_latency = 0);
+// limit the number of frames drawn per second
+// fps = 0: every change is drawn immediately (default)
+// fps > 0: the print and delete functions only change the text
+// buffer. tb_display_update() draws all changes since the last
+// frame at once, but not more than fps times per second.
+// Many new lines between two frames cost only one redraw.
+// max_latency = maximum time in milliseconds from the first change
+// to its frame (0 = only the frame rate counts). A change is drawn
+// after max_latency milliseconds even if the time for the next
+// frame is not reached yet. So with a max_latency shorter than
+// 1000/fps, there can be up to 1000/max_latency frames per second.
+// example:
+//    tb_display_set_frame_rate(25);
+//    ...
+//    tb_display_update(); // in the loop()
+// =============================================================
+void tb_display_set_frame_rate(int fps, int max_latency = 0);
+
+// =============================================================
+//           tb_display_update();
+// draw the changes of the text buffer if the time for the next
+// frame is reached
+// call it as often as possible in the loop()
+// returns true if a frame was drawn
+// =============================================================
+bool tb_display_update();
+
+// =============================================================
+//           tb_display_status_field(int n, int row, int x, int width);
+// define the status field n (0 - TB_DISPLAY_STATUS_FIELDS-1)
+// at the status row "row" (see tb_display_status_rows), from
+// the x position "x" with "width" pixels
+// The field is empty. A field outside of the status rows or the
+// screen is not shown (e.g. after a rotation).
+// The text starts a few pixels right of x, like the rows of the
+// scrolling text.
+// returns false if n is not a field or the width is not possible
+// (max. 255 pixels)
+// =============================================================
+bool tb_display_status_field(int n, int row, int x, int width);
+
+// =============================================================
+//           tb_display_status_set(int n, const char *value);
+// show "value" in the status field n
+// Only the characters that differ from the characters on the
+// screen are drawn, the scrolling text is not touched. This is
+// fast enough for a value that changes 50 times per second.
+// The field has at most TB_DISPLAY_STATUS_LENGTH-1 characters,
+// characters that do not fit into the field are cut off.
+// With the render task, call it between tb_display_lock() and
+// tb_display_unlock().
+// example:
+//    tb_display_status_rows = 1;
+//    tb_display_init(1);
+//    tb_display_status_field(0, 0, 0, 120);
+//    ...
+//    snprintf(value, sizeof(value), "T=%d.%dC", t/10, t%10);
+//    tb_display_status_set(0, value);
+// =============================================================
+void tb_display_status_set(int n, const char *value);
+
+// =============================================================
+//           tb_display_status_color(int n, uint8_t attr);
+// colors of the status field n (like the escape sequences:
+// foreground color in the low 4 bits, background color in the
+// high 4 bits, default 0x0F = white on black)
+// =============================================================
+void tb_display_status_color(int n, uint8_t attr);
@@ -0,0 +1,139 @@
+/******************************************************************************
+ * tb_display_backend.h
+ * Display backends for the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * All drawing of the library goes through a small table of functions.
+ * Available backends:
+ *   tb_display_backend_m5stickc     = LCD of the M5StickC
+ *   tb_display_backend_m5stickcplus = LCD of the M5StickCPlus
+ *   tb_display_backend_framebuffer  = RGB565 in-memory framebuffer
+ *   tb_display_backend_counter      = counting LCD stub (draws nothing)
+ * Only the backend of the chosen M5Stick type (see tb_display_config.h)
+ * exists in a build, because both M5 libraries define the same objects.
+ * The framebuffer is always available. Its frames can be written as
+ * PPM image files to profile and check the rendering on a Linux host.
+ * The framebuffer emulates the scroll offset register of the LCD
+ * controller, so the hardware scroll can be checked without an LCD.
+ * The counter backend is always available as well. It counts the
+ * bytes the LCD backends would send to the LCD controller.
+ * Both backends copy the characters from the glyph cache
+ * (tb_display_glyph_cache.h) instead of drawing them from the font.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_BACKEND_H
+#define TB_DISPLAY_BACKEND_H
+
+#include <stdint.h>
+#include "tb_display_config.h"
+
+typedef struct {
+  // name of the backend (for debug messages)
+  const char *name;
+  // size of the screen in landscape orientation
+  int screen_width;
+  int screen_height;
+  // same rotation values as tb_display_init()
+  void (*set_rotation)(int rotation);
+  void (*fill_screen)(uint16_t color);
+  void (*fill_rect)(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+  // draw a character with the given font number
+  // (the characters 128 - 255 with the extended font,
+  // see tb_display_charset.h)
+  // returns the width of the character in pixel
+  int16_t (*draw_char)(uint16_t c, int32_t x, int32_t y, uint8_t font);
+  // width of a character in pixel without drawing it
+  int16_t (*char_width)(uint16_t c, uint8_t font);
+  // table with the widths of the characters 32 - 127 of the font
+  // used by the library (NULL: measured once with char_width)
+  const uint8_t *glyph_widths;
+  // hardware vertical scroll (NULL if not supported by the backend)
+  // scroll_init setup the scroll area for the rotation and sets the
+  // scroll offset to 0. It returns false if the rotation does not
+  // allow to scroll the text rows in hardware (e.g. landscape mode).
+  bool (*scroll_init)(int rotation);
+  // the line "offset" of the display memory is shown at the top
+  // of the screen, the lines above are shown at the bottom
+  void (*scroll_to)(int32_t offset);
+  // off-screen sprite for a part of a text row (NULL if not supported)
+  // The characters are drawn in the sprite and the sprite is pushed
+  // with one transfer to the screen.
+  // sprite_create returns false if there is not enough memory
+  bool (*sprite_create)(int32_t w, int32_t h);
+  void (*sprite_fill)(uint16_t color);
+  int16_t (*sprite_draw_char)(uint16_t c, int32_t x, int32_t y, uint8_t font);
+  void (*sprite_push)(int32_t x, int32_t y);
+  // colors for the following characters on the screen and in the sprite
+  // (NULL if not supported: the characters have the actual text color)
+  // With bgcolor = color, only the character is drawn. Otherwise
+  // the background of the character is filled with bgcolor.
+  void (*set_text_color)(uint16_t color, uint16_t bgcolor);
+} tb_display_backend;
+
+#ifndef TB_DISPLAY_HOST
+extern const tb_display_backend TB_DISPLAY_BOARD_BACKEND;
+#endif
+extern const tb_display_backend tb_display_backend_framebuffer;
+extern const tb_display_backend tb_display_backend_counter;
+
+// =============================================================
+//           tb_display_set_backend(backend);
+// select the backend for all following drawing
+// call tb_display_init() afterwards to setup the new screen
+// example:
+//    tb_display_set_backend(&tb_display_backend_framebuffer);
+//    tb_display_init(1);
+// =============================================================
+void tb_display_set_backend(const tb_display_backend *backend);
+
+// =============================================================
+//           tb_display_get_backend();
+// returns the actual backend
+// =============================================================
+const tb_display_backend *tb_display_get_backend();
+
+// =============================================================
+//           tb_display_framebuffer_...
+// access to the RGB565 framebuffer
+// Width and height follow the actual rotation.
+// The pixel memory is allocated with the first tb_display_init()
+// and is NULL before.
+// =============================================================
+uint16_t *tb_display_framebuffer_pixels();
+int tb_display_framebuffer_width();
+int tb_display_framebuffer_height();
+void tb_display_framebuffer_set_text_color(uint16_t color);
+// the emulated scroll offset register of the LCD controller
+int tb_display_framebuffer_scroll_offset();
+
+// =============================================================
+//           tb_display_framebuffer_write_ppm(const char *filename);
+// write the actual frame as binary PPM (P6) image file
+// The frame is written as shown on the screen (with scroll offset)
+// returns false if the file could not be written
+// example:
+//    tb_display_framebuffer_write_ppm("frame_0001.ppm");
+// =============================================================
+bool tb_display_framebuffer_write_ppm(const char *filename);
+
+// =============================================================
+//           tb_display_counter_...
+// the counts of the counter backend
+// bytes     = bytes that would be sent to the LCD controller
+//             (commands and 2 bytes per pixel)
+// transfers = number of transfers (a character, a filled rectangle,
+//             a pushed sprite or a scroll command)
+// example:
+//    tb_display_set_backend(&tb_display_backend_counter);
+//    tb_display_init(1);
+//    tb_display_counter_reset();
+//    tb_display_print_String("Hello\n");
+//    uint32_t bytes = tb_display_counter_bytes();
+// =============================================================
+uint32_t tb_display_counter_bytes();
+uint32_t tb_display_counter_transfers();
+void tb_display_counter_reset();
+
+#endif // TB_DISPLAY_BACKEND_H
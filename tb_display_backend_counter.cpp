@@ -0,0 +1,150 @@
+/******************************************************************************
+ * tb_display_backend_counter.cpp
+ * Counting LCD stub backend for the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The counter backend draws nothing. It counts the bytes that the
+ * LCD backends would send over the SPI bus to the LCD controller:
+ * every transfer of pixels sets the window first (CASET, RASET and
+ * RAMWR = 11 bytes) and then sends 2 bytes per pixel.
+ * The characters have the widths of the framebuffer font, so the
+ * layout is the same as with the framebuffer backend.
+ * The time of the library without the time of the LCD can be
+ * measured with this backend (see tb_display_bench.h).
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include "tb_display_backend.h"
+
+// bytes of the commands to set the window for the pixels
+#define COUNTER_WINDOW_BYTES 11
+// bytes of the scroll start command
+#define COUNTER_SCROLL_BYTES 3
+
+static uint32_t counter_bytes = 0;
+static uint32_t counter_transfers = 0;
+// size of the screen with the actual rotation
+static int counter_width = SCREEN_WIDTH;
+static int counter_height = SCREEN_HEIGHT;
+// size of the row sprite
+static int32_t counter_sprite_width = 0;
+static int32_t counter_sprite_height = 0;
+
+// one transfer of w x h pixels (clipped to the screen)
+static void counter_pixels(int32_t x, int32_t y, int32_t w, int32_t h){
+  if(x < 0) { w += x; x = 0; }
+  if(y < 0) { h += y; y = 0; }
+  if(x + w > counter_width) w = counter_width - x;
+  if(y + h > counter_height) h = counter_height - y;
+  if(w <= 0 || h <= 0)
+    return;
+  counter_bytes += COUNTER_WINDOW_BYTES + w*h*2;
+  counter_transfers++;
+}
+
+static void counter_set_rotation(int rotation){
+  // 1 and 3 = landscape mode
+  if(rotation & 1){
+    counter_width = SCREEN_WIDTH;
+    counter_height = SCREEN_HEIGHT;
+  } else {
+    counter_width = SCREEN_HEIGHT;
+    counter_height = SCREEN_WIDTH;
+  }
+}
+
+static void counter_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color){
+  (void)color;
+  counter_pixels(x, y, w, h);
+}
+
+static void counter_fill_screen(uint16_t color){
+  counter_fill_rect(0, 0, counter_width, counter_height, color);
+}
+
+static int16_t counter_char_width(uint16_t c, uint8_t font){
+  return tb_display_backend_framebuffer.char_width(c, font);
+}
+
+static int16_t counter_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  int16_t width = counter_char_width(c, font);
+  counter_pixels(x, y, width, TEXT_HEIGHT);
+  return width;
+}
+
+// the scroll offset of the LCD controller, only in portrait mode
+static bool counter_scroll_init(int rotation){
+  counter_bytes += COUNTER_SCROLL_BYTES;
+  counter_transfers++;
+  return (rotation & 1) == 0;
+}
+
+static void counter_scroll_to(int32_t offset){
+  (void)offset;
+  counter_bytes += COUNTER_SCROLL_BYTES;
+  counter_transfers++;
+}
+
+// the sprite is in the memory, only the push is a transfer
+static bool counter_sprite_create(int32_t w, int32_t h){
+  counter_sprite_width = w;
+  counter_sprite_height = h;
+  return true;
+}
+
+static void counter_sprite_fill(uint16_t color){
+  (void)color;
+}
+
+static int16_t counter_sprite_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  (void)x;
+  (void)y;
+  return counter_char_width(c, font);
+}
+
+static void counter_sprite_push(int32_t x, int32_t y){
+  counter_pixels(x, y, counter_sprite_width, counter_sprite_height);
+}
+
+static void counter_set_text_color(uint16_t color, uint16_t bgcolor){
+  (void)color;
+  (void)bgcolor;
+}
+
+const tb_display_backend tb_display_backend_counter = {
+  "Counter",
+  SCREEN_WIDTH,
+  SCREEN_HEIGHT,
+  counter_set_rotation,
+  counter_fill_screen,
+  counter_fill_rect,
+  counter_draw_char,
+  counter_char_width,
+  NULL,
+  counter_scroll_init,
+  counter_scroll_to,
+  counter_sprite_create,
+  counter_sprite_fill,
+  counter_sprite_draw_char,
+  counter_sprite_push,
+  counter_set_text_color
+};
+
+uint32_t tb_display_counter_bytes(){
+  return counter_bytes;
+}
+
+uint32_t tb_display_counter_transfers(){
+  return counter_transfers;
+}
+
+void tb_display_counter_reset(){
+  counter_bytes = 0;
+  counter_transfers = 0;
+}
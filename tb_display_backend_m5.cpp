@@ -0,0 +1,272 @@
+/******************************************************************************
+ * tb_display_backend_m5.cpp
+ * LCD backends of the M5StickC and M5StickCPlus for the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Only the backend of the chosen M5Stick type is compiled
+ * (see tb_display_config.h).
+ * The fonts of the M5Stick have only ASCII characters. The characters
+ * 128 - 255 are drawn with the extended font (tb_display_charset.h).
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_HOST
+
+#include <Arduino.h>
+#include "tb_display_backend.h"
+#include "tb_display_charset.h"
+#include "tb_display_glyph_cache.h"
+
+// import the right lib
+#ifdef M5STICKC
+  #include <M5StickC.h>
+#endif
+#ifdef M5STICKCPLUS
+  #include "M5StickCPlus.h"
+#endif
+
+// Vertical scroll of the LCD controller (ST7735S and ST7789v2)
+// The scroll area are the visible lines of the display memory.
+// The visible lines are in the middle of the display memory:
+#ifdef M5STICKC
+  // ST7735S: 162 lines of display memory, 160 visible from line 1
+  #define LCD_SCROLL_TOP 1
+  #define LCD_MEMORY_LINES 162
+#endif
+#ifdef M5STICKCPLUS
+  // ST7789v2: 320 lines of display memory, 240 visible from line 40
+  #define LCD_SCROLL_TOP 40
+  #define LCD_MEMORY_LINES 320
+#endif
+#define LCD_SCROLL_LINES SCREEN_WIDTH
+// controller commands
+#define LCD_CMD_VSCRDEF 0x33
+#define LCD_CMD_VSCSAD  0x37
+
+static int m5_rotation = 1;
+
+static void m5_set_rotation(int rotation){
+  m5_rotation = rotation;
+  M5.Lcd.setRotation(rotation);
+}
+
+static void m5_fill_screen(uint16_t color){
+  M5.Lcd.fillScreen(color);
+}
+
+static void m5_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color){
+  M5.Lcd.fillRect(x, y, w, h, color);
+}
+
+static int16_t m5_char_width(uint16_t c, uint8_t font){
+  if(c > 127)
+    return tb_display_charset_width(c);
+  char text[2] = {(char)c, '\0'};
+  return M5.Lcd.textWidth(text, font);
+}
+
+// the characters of the font TEXT_SIZE are rendered once in a small
+// sprite and then copied from the glyph cache
+// (the sprite is not smaller than the widest character)
+#define M5_GLYPH_SPRITE_WIDTH TEXT_HEIGHT
+static TFT_eSprite *m5_glyph_sprite = NULL;
+static bool m5_glyph_failed = false;
+// widths of the characters 32 - 127
+static uint8_t m5_glyph_width[96];
+
+static void m5_render_glyph(uint16_t *pixels, uint16_t c, int width,
+                            uint16_t color, uint16_t bgcolor){
+  // The rows are erased black before the characters are drawn, so
+  // a character without background is rendered on black.
+  m5_glyph_sprite->fillSprite(bgcolor == color ? TFT_BLACK : bgcolor);
+  m5_glyph_sprite->setTextColor(color, bgcolor);
+  m5_glyph_sprite->drawChar(c, 0, 0, TEXT_SIZE);
+  for(int y = 0; y < TEXT_HEIGHT; y++){
+    for(int x = 0; x < width; x++)
+      pixels[y*width + x] = m5_glyph_sprite->readPixel(x, y);
+  }
+}
+
+// returns the pixels of the character with the actual text color
+// or NULL if the character is not cached
+static const uint16_t *m5_cached_glyph(uint16_t c, uint8_t font, int *width){
+  if(font != TEXT_SIZE || c < 32 || c > 127 || m5_glyph_failed)
+    return NULL;
+  if(m5_glyph_sprite == NULL){
+    m5_glyph_sprite = new TFT_eSprite(&M5.Lcd);
+    m5_glyph_sprite->setColorDepth(16);
+    if(m5_glyph_sprite->createSprite(M5_GLYPH_SPRITE_WIDTH, TEXT_HEIGHT) == NULL){
+      m5_glyph_failed = true;
+      return NULL;
+    }
+    for(int n = 0; n < 96; n++)
+      m5_glyph_width[n] = m5_char_width(n+32, TEXT_SIZE);
+  }
+  *width = m5_glyph_width[c-32];
+  if(*width > M5_GLYPH_SPRITE_WIDTH)
+    return NULL;
+  return tb_display_glyph_cache_get(c, *width, M5.Lcd.textcolor, M5.Lcd.textbgcolor, m5_render_glyph);
+}
+
+// render an extended character (128 - 255) with the actual text color
+// (the width of the extended characters is smaller than TEXT_HEIGHT)
+// returns the width of the character
+static int m5_render_extended(uint16_t *pixels, uint16_t c){
+  int width = tb_display_charset_width(c);
+  uint16_t color = M5.Lcd.textcolor;
+  uint16_t bgcolor = M5.Lcd.textbgcolor;
+  for(int n = 0; n < width*TEXT_HEIGHT; n++)
+    pixels[n] = bgcolor == color ? TFT_BLACK : bgcolor;
+  tb_display_charset_draw(pixels, width, TEXT_HEIGHT, c, 0, 0, color);
+  return width;
+}
+
+// the pixels of the cache are normal RGB565 values,
+// the LCD expects the high byte first
+static int16_t m5_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  int width = 0;
+  uint16_t extended[TEXT_HEIGHT*TEXT_HEIGHT];
+  const uint16_t *glyph = NULL;
+  if(c > 127){
+    width = m5_render_extended(extended, c);
+    glyph = extended;
+  } else {
+    glyph = m5_cached_glyph(c, font, &width);
+  }
+  if(glyph == NULL)
+    return M5.Lcd.drawChar(c, x, y, font);
+  M5.Lcd.setSwapBytes(true);
+  M5.Lcd.pushImage(x, y, width, TEXT_HEIGHT, glyph);
+  M5.Lcd.setSwapBytes(false);
+  return width;
+}
+
+static void m5_write_scroll_start(int32_t line){
+  M5.Lcd.writecommand(LCD_CMD_VSCSAD);
+  M5.Lcd.writedata(line >> 8);
+  M5.Lcd.writedata(line & 0xFF);
+}
+
+// The controller scrolls along the memory lines = the long side
+// of the screen. Only in portrait mode (rotation 2 and 4) these
+// are the text rows. In landscape mode, the text would scroll sideways.
+static bool m5_scroll_init(int rotation){
+  int bottom = LCD_MEMORY_LINES - LCD_SCROLL_TOP - LCD_SCROLL_LINES;
+  M5.Lcd.writecommand(LCD_CMD_VSCRDEF);
+  M5.Lcd.writedata(LCD_SCROLL_TOP >> 8);
+  M5.Lcd.writedata(LCD_SCROLL_TOP & 0xFF);
+  M5.Lcd.writedata(LCD_SCROLL_LINES >> 8);
+  M5.Lcd.writedata(LCD_SCROLL_LINES & 0xFF);
+  M5.Lcd.writedata(bottom >> 8);
+  M5.Lcd.writedata(bottom & 0xFF);
+  m5_write_scroll_start(LCD_SCROLL_TOP);
+  return (rotation & 1) == 0;
+}
+
+static void m5_scroll_to(int32_t offset){
+  offset = offset % LCD_SCROLL_LINES;
+  if(offset < 0)
+    offset += LCD_SCROLL_LINES;
+  // with rotation 2, the memory is written bottom up
+  // so the scroll direction of the memory lines is reversed
+  if((m5_rotation % 4) == 2)
+    offset = (LCD_SCROLL_LINES - offset) % LCD_SCROLL_LINES;
+  m5_write_scroll_start(LCD_SCROLL_TOP + offset);
+}
+
+// the row sprite
+static TFT_eSprite *m5_sprite = NULL;
+static int32_t m5_sprite_width = 0;
+static int32_t m5_sprite_height = 0;
+
+static bool m5_sprite_create(int32_t w, int32_t h){
+  if(m5_sprite == NULL)
+    m5_sprite = new TFT_eSprite(&M5.Lcd);
+  if(w == m5_sprite_width && h == m5_sprite_height)
+    return true;
+  if(m5_sprite_width > 0)
+    m5_sprite->deleteSprite();
+  m5_sprite_width = 0;
+  m5_sprite_height = 0;
+  m5_sprite->setColorDepth(16);
+  if(m5_sprite->createSprite(w, h) == NULL)
+    return false;
+  m5_sprite_width = w;
+  m5_sprite_height = h;
+  return true;
+}
+
+static void m5_sprite_fill(uint16_t color){
+  // same text color as on the LCD
+  m5_sprite->setTextColor(M5.Lcd.textcolor, M5.Lcd.textbgcolor);
+  m5_sprite->fillSprite(color);
+}
+
+static int16_t m5_sprite_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  if(c > 127){
+    // the pixels are set one by one (in the memory of the sprite)
+    uint16_t extended[TEXT_HEIGHT*TEXT_HEIGHT];
+    int width = m5_render_extended(extended, c);
+    for(int row = 0; row < TEXT_HEIGHT; row++){
+      for(int col = 0; col < width; col++)
+        m5_sprite->drawPixel(x+col, y+row, extended[row*width + col]);
+    }
+    return width;
+  }
+  return m5_sprite->drawChar(c, x, y, font);
+}
+
+static void m5_sprite_push(int32_t x, int32_t y){
+  m5_sprite->pushSprite(x, y);
+}
+
+static void m5_set_text_color(uint16_t color, uint16_t bgcolor){
+  M5.Lcd.setTextColor(color, bgcolor);
+  if(m5_sprite != NULL)
+    m5_sprite->setTextColor(color, bgcolor);
+}
+
+#ifdef M5STICKC
+const tb_display_backend tb_display_backend_m5stickc = {
+  "M5StickC",
+  SCREEN_WIDTH,
+  SCREEN_HEIGHT,
+  m5_set_rotation,
+  m5_fill_screen,
+  m5_fill_rect,
+  m5_draw_char,
+  m5_char_width,
+  NULL,
+  m5_scroll_init,
+  m5_scroll_to,
+  m5_sprite_create,
+  m5_sprite_fill,
+  m5_sprite_draw_char,
+  m5_sprite_push,
+  m5_set_text_color
+};
+#endif
+
+#ifdef M5STICKCPLUS
+const tb_display_backend tb_display_backend_m5stickcplus = {
+  "M5StickCPlus",
+  SCREEN_WIDTH,
+  SCREEN_HEIGHT,
+  m5_set_rotation,
+  m5_fill_screen,
+  m5_fill_rect,
+  m5_draw_char,
+  m5_char_width,
+  NULL,
+  m5_scroll_init,
+  m5_scroll_to,
+  m5_sprite_create,
+  m5_sprite_fill,
+  m5_sprite_draw_char,
+  m5_sprite_push,
+  m5_set_text_color
+};
+#endif
+
+#endif // TB_DISPLAY_HOST
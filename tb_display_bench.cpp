@@ -0,0 +1,270 @@
+/******************************************************************************
+ * tb_display_bench.cpp
+ * Benchmark and frame check of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdio.h>
+#include "tb_display.h"
+#include "tb_display_backend.h"
+#include "tb_display_bench.h"
+
+// the rotation of the benchmark
+#define BENCH_ROTATION 1
+
+// CRC-32 of the frame in the middle and of the last frame of each
+// workload (framebuffer, rotation 1, default settings)
+#ifdef M5STICKC
+static const uint32_t bench_golden_middle[TB_DISPLAY_BENCH_WORKLOADS] = {
+  0x7E5C602A, 0x1A54BC15, 0xF4E9E6B5, 0x714055A1
+};
+static const uint32_t bench_golden[TB_DISPLAY_BENCH_WORKLOADS] = {
+  0x5EDF369A, 0x66356DA1, 0xE6592E40, 0x86EFDA82
+};
+#endif
+#ifdef M5STICKCPLUS
+static const uint32_t bench_golden_middle[TB_DISPLAY_BENCH_WORKLOADS] = {
+  0x305D5120, 0x0DFA9DAF, 0x3BFD8CCB, 0x3DED58F3
+};
+static const uint32_t bench_golden[TB_DISPLAY_BENCH_WORKLOADS] = {
+  0x904DDD12, 0x11F8E765, 0xF88167AC, 0xA6EF92A1
+};
+#endif
+
+// the same random texts in every run
+static uint32_t bench_random_state;
+
+static uint32_t bench_random(uint32_t range){
+  bench_random_state = bench_random_state*1103515245 + 12345;
+  return (bench_random_state >> 16) % range;
+}
+
+// the frame in the middle of a workload
+// (only taken once and only in the run with the framebuffer)
+static bool bench_middle_pending = false;
+static bool bench_middle_taken;
+static uint32_t bench_middle_crc;
+static bool bench_frame_crc(uint32_t *crc);
+
+static void bench_middle_frame(){
+  if(!bench_middle_pending)
+    return;
+  bench_middle_pending = false;
+  bench_middle_taken = bench_frame_crc(&bench_middle_crc);
+}
+
+// a word of random lower case letters
+static int bench_word(char *word, int length){
+  for(int n = 0; n < length; n++)
+    word[n] = 'a' + bench_random(26);
+  word[length] = '\0';
+  return length;
+}
+
+// =============================================================
+// the workloads
+// return the number of printed characters
+// =============================================================
+static uint32_t bench_log_lines(){
+  uint32_t chars = 0;
+  char line[64];
+  for(int n = 0; n < 200; n++){
+    int length = snprintf(line, sizeof(line), "[%6lu] sensor %u: %u.%u C %s\n",
+                          1000UL + n*37UL, (unsigned)bench_random(8), (unsigned)bench_random(40),
+                          (unsigned)bench_random(10), bench_random(10) == 0 ? "error" : "ok");
+    tb_display_print_String(line);
+    chars += length;
+    if(n == 100)
+      bench_middle_frame();
+  }
+  return chars;
+}
+
+static uint32_t bench_long_tokens(){
+  static const char hex[] = "0123456789ABCDEF";
+  uint32_t chars = 0;
+  for(int n = 0; n < 60; n++){
+    int length = 20 + bench_random(130);
+    for(int c = 0; c < length; c++)
+      tb_display_print_char(hex[bench_random(16)]);
+    tb_display_print_char(bench_random(3) == 0 ? '\n' : ' ');
+    chars += length + 1;
+    if(n == 30)
+      bench_middle_frame();
+  }
+  return chars;
+}
+
+static uint32_t bench_word_wrap(){
+  uint32_t chars = 0;
+  char word[16];
+  for(int n = 0; n < 1000; n++){
+    int length = bench_word(word, 1 + bench_random(12));
+    word[length++] = bench_random(40) == 0 ? '\n' : ' ';
+    word[length] = '\0';
+    tb_display_print_String(word);
+    chars += length;
+    if(n == 500)
+      bench_middle_frame();
+  }
+  return chars;
+}
+
+static uint32_t bench_backspace(){
+  uint32_t chars = 0;
+  char word[16];
+  for(int n = 0; n < 400; n++){
+    int length = bench_word(word, 1 + bench_random(8));
+    for(int c = 0; c < length; c++)
+      tb_display_print_char(word[c]);
+    tb_display_print_char(' ');
+    chars += length + 1;
+    // a storm of deleted characters
+    if(bench_random(4) == 0){
+      int count = 1 + bench_random(20);
+      for(int c = 0; c < count; c++)
+        tb_display_delete_char();
+      chars += count;
+      // right after the first storm in the second half
+      if(n >= 200)
+        bench_middle_frame();
+    }
+    if(bench_random(15) == 0){
+      tb_display_new_line();
+      chars++;
+    }
+  }
+  return chars;
+}
+
+typedef struct {
+  const char *name;
+  uint32_t (*run)();
+} bench_workload;
+
+static const bench_workload bench_workloads[TB_DISPLAY_BENCH_WORKLOADS] = {
+  {"log lines", bench_log_lines},
+  {"long tokens", bench_long_tokens},
+  {"word wrap", bench_word_wrap},
+  {"backspace", bench_backspace},
+};
+
+// =============================================================
+// CRC-32 of the framebuffer (the pixels as shown on the screen)
+// returns false if the framebuffer has no memory
+// =============================================================
+static bool bench_frame_crc(uint32_t *frame_crc){
+  const uint16_t *pixels = tb_display_framebuffer_pixels();
+  if(pixels == NULL)
+    return false;
+  int width = tb_display_framebuffer_width();
+  int height = tb_display_framebuffer_height();
+  int offset = tb_display_framebuffer_scroll_offset();
+  uint32_t crc = 0xFFFFFFFF;
+  for(int y = 0; y < height; y++){
+    const uint16_t *line = pixels + ((y + offset) % height)*width;
+    for(int x = 0; x < width; x++){
+      uint8_t bytes[2] = {(uint8_t)(line[x] & 0xFF), (uint8_t)(line[x] >> 8)};
+      for(int b = 0; b < 2; b++){
+        crc ^= bytes[b];
+        for(int bit = 0; bit < 8; bit++)
+          crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+      }
+    }
+  }
+  *frame_crc = ~crc;
+  return true;
+}
+
+// =============================================================
+// an empty screen on the backend and the random texts of the
+// workload n
+// =============================================================
+static void bench_setup(int n, const tb_display_backend *backend){
+  tb_display_set_backend(backend);
+  tb_display_init(BENCH_ROTATION);
+  bench_random_state = n + 1;
+}
+
+// =============================================================
+// run all workloads
+// =============================================================
+bool tb_display_bench_run(tb_display_bench_result *results, int ScreenRotation){
+  // the benchmark runs with the default settings,
+  // the actual settings are restored afterwards
+  const tb_display_backend *backend = tb_display_get_backend();
+  boolean word_wrap = tb_display_word_wrap;
+  boolean utf8 = tb_display_utf8;
+  boolean ansi = tb_display_ansi;
+  boolean hw_scroll = tb_display_hw_scroll;
+  boolean row_sprite = tb_display_row_sprite;
+  int status_rows = tb_display_status_rows;
+  tb_display_word_wrap = true;
+  tb_display_utf8 = true;
+  tb_display_ansi = false;
+  tb_display_hw_scroll = false;
+  tb_display_row_sprite = false;
+  tb_display_status_rows = 0;
+  tb_display_set_frame_rate(0);
+  bool frames_ok = true;
+  for(int n = 0; n < TB_DISPLAY_BENCH_WORKLOADS; n++){
+    tb_display_bench_result *result = &results[n];
+    result->name = bench_workloads[n].name;
+    // time and bytes with the counting LCD stub
+    bench_setup(n, &tb_display_backend_counter);
+    tb_display_counter_reset();
+    unsigned long start = micros();
+    result->chars = bench_workloads[n].run();
+    result->time_us = micros() - start;
+    result->lcd_bytes = tb_display_counter_bytes();
+    result->lcd_transfers = tb_display_counter_transfers();
+    result->chars_per_second = result->time_us > 0 ?
+      (uint32_t)((uint64_t)result->chars * 1000000 / result->time_us) : 0;
+    // the frames in the framebuffer
+    bench_setup(n, &tb_display_backend_framebuffer);
+    bench_middle_pending = true;
+    bench_middle_taken = false;
+    bench_workloads[n].run();
+    bench_middle_pending = false;
+    result->frames_taken = bench_frame_crc(&result->frame_crc) && bench_middle_taken;
+    result->middle_crc = bench_middle_taken ? bench_middle_crc : 0;
+    if(!result->frames_taken)
+      result->frame_crc = 0;
+    result->golden_middle_crc = bench_golden_middle[n];
+    result->golden_crc = bench_golden[n];
+    if(!result->frames_taken || result->middle_crc != result->golden_middle_crc ||
+       result->frame_crc != result->golden_crc)
+      frames_ok = false;
+  }
+  tb_display_word_wrap = word_wrap;
+  tb_display_utf8 = utf8;
+  tb_display_ansi = ansi;
+  tb_display_hw_scroll = hw_scroll;
+  tb_display_row_sprite = row_sprite;
+  tb_display_status_rows = status_rows;
+  tb_display_set_backend(backend);
+  tb_display_init(ScreenRotation);
+  return frames_ok;
+}
+
+// =============================================================
+// compare the results with the results of an older run
+// =============================================================
+bool tb_display_bench_compare(const tb_display_bench_result *results,
+                              const tb_display_bench_result *baseline, int tolerance){
+  bool ok = true;
+  for(int n = 0; n < TB_DISPLAY_BENCH_WORKLOADS; n++){
+    uint64_t min_speed = (uint64_t)baseline[n].chars_per_second * (100 - tolerance) / 100;
+    uint64_t max_bytes = (uint64_t)baseline[n].lcd_bytes * (100 + tolerance) / 100;
+    if(results[n].chars_per_second < min_speed || results[n].lcd_bytes > max_bytes)
+      ok = false;
+  }
+  return ok;
+}
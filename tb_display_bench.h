@@ -0,0 +1,94 @@
+/******************************************************************************
+ * tb_display_bench.h
+ * Benchmark and frame check of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The benchmark prints typical texts with tb_display_print_char,
+ * tb_display_print_String, tb_display_delete_char and
+ * tb_display_new_line (the workloads):
+ *   log lines   = short lines with numbers, one print_String per line
+ *   long tokens = long words without spaces, character by character
+ *   word wrap   = long lines of short words, nearly every row wraps
+ *   backspace   = typing with many deleted characters
+ * Each workload runs twice:
+ * - with the counting LCD stub (tb_display_backend_counter): the time
+ *   of the library and the bytes that would be sent to the LCD
+ * - with the framebuffer: the CRC-32 of a frame in the middle of the
+ *   workload (e.g. right after deleted characters) and of the last
+ *   frame are compared with the golden frames of this version
+ * Both run in landscape mode (rotation 1) with the default settings
+ * (Word-Wrap, UTF-8, no escape sequences, no hardware scroll, no row
+ * sprite, no status rows, no frame rate limit). The same workloads
+ * give the same frames on the M5Stick and on a Linux host
+ * (TB_DISPLAY_HOST). tb_bench_check.cpp runs the benchmark on a
+ * Linux host and fails on a difference or a regression.
+ *
+ * The text buffer and the history are cleared. Afterwards, the
+ * settings and the backend are restored and the screen is setup
+ * again with tb_display_init(). The frame rate has to be set again.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_BENCH_H
+#define TB_DISPLAY_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// number of workloads
+#define TB_DISPLAY_BENCH_WORKLOADS 4
+
+// the result of a workload
+typedef struct {
+  const char *name;
+  // characters printed (a deleted character and a new line count
+  // as one character as well)
+  uint32_t chars;
+  // time with the counting LCD stub in microseconds
+  uint32_t time_us;
+  uint32_t chars_per_second;
+  // bytes and transfers that would be sent to the LCD
+  uint32_t lcd_bytes;
+  uint32_t lcd_transfers;
+  // CRC-32 of the last frame (framebuffer) and the golden frame
+  uint32_t frame_crc;
+  uint32_t golden_crc;
+  // CRC-32 of the frame in the middle and the golden frame
+  uint32_t middle_crc;
+  uint32_t golden_middle_crc;
+  // false if the framebuffer has no memory (no frames, the CRCs are 0)
+  bool frames_taken;
+} tb_display_bench_result;
+
+// =============================================================
+//           tb_display_bench_run(results, ScreenRotation);
+// run all workloads
+// "results" has TB_DISPLAY_BENCH_WORKLOADS entries
+// The screen is setup with ScreenRotation afterwards.
+// returns false if a frame differs from the golden frames or if
+// the framebuffer has no memory for the frames
+// example:
+//    tb_display_bench_result results[TB_DISPLAY_BENCH_WORKLOADS];
+//    tb_display_bench_run(results, 1);
+//    printf("%s: %u chars/s, %u bytes/char\n", results[0].name,
+//           results[0].chars_per_second,
+//           results[0].lcd_bytes / results[0].chars);
+// =============================================================
+bool tb_display_bench_run(tb_display_bench_result *results, int ScreenRotation);
+
+// =============================================================
+//           tb_display_bench_compare(results, baseline, tolerance);
+// compare the results with the results of an older run
+// returns false if a workload is more than "tolerance" percent
+// slower than the baseline, or sends more than "tolerance"
+// percent more bytes to the LCD
+// example:
+//    // values of the last release on this board
+//    if(!tb_display_bench_compare(results, baseline, 10))
+//      Serial.println("performance regression");
+// =============================================================
+bool tb_display_bench_compare(const tb_display_bench_result *results,
+                              const tb_display_bench_result *baseline, int tolerance);
+
+#endif // TB_DISPLAY_BENCH_H
@@ -0,0 +1,371 @@
+/******************************************************************************
+ * tb_display_charset.cpp
+ * Extended characters of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include "tb_display_charset.h"
+
+// a part of a character
+typedef struct {
+  // the first pixel row
+  uint8_t y;
+  // pixel per row
+  uint8_t height;
+  // one byte per column, bit 0 = top row
+  uint8_t columns[5];
+} tb_display_charset_shape;
+
+// a character: the shape, the accent (0 = none) and the pixel row
+// of the accent (the accent of a small letter is one pixel lower)
+typedef struct {
+  uint8_t shape;
+  uint8_t accent;
+  uint8_t accent_y;
+} tb_display_charset_char;
+
+// the shapes of the characters: first pixel row, pixel per row
+// and 5 columns (bit 0 = top row)
+static const tb_display_charset_shape charset_shapes[97] = {
+  {0, 2, {0x00, 0x00, 0x00, 0x00, 0x00}}, // blank
+  {1, 2, {0x14, 0x3E, 0x55, 0x55, 0x41}}, // euro
+  {1, 2, {0x4E, 0x71, 0x01, 0x71, 0x4E}}, // ohm
+  {1, 2, {0x00, 0x40, 0x20, 0x00, 0x00}}, // quote low
+  {1, 2, {0x40, 0x44, 0x3E, 0x05, 0x01}}, // florin
+  {1, 2, {0x40, 0x20, 0x00, 0x40, 0x20}}, // quotes low
+  {1, 2, {0x40, 0x00, 0x40, 0x00, 0x40}}, // ellipsis
+  {1, 2, {0x02, 0x02, 0x7F, 0x02, 0x02}}, // dagger
+  {1, 2, {0x22, 0x22, 0x7F, 0x22, 0x22}}, // double dagger
+  {1, 2, {0x00, 0x02, 0x01, 0x02, 0x00}}, // circumflex
+  {1, 2, {0x23, 0x13, 0x48, 0x24, 0x42}}, // per mille
+  {1, 2, {0x00, 0x08, 0x14, 0x22, 0x00}}, // angle left
+  {1, 2, {0x3E, 0x41, 0x7F, 0x49, 0x49}}, // OE
+  {1, 2, {0x04, 0x02, 0x7F, 0x02, 0x04}}, // arrow up
+  {1, 2, {0x10, 0x20, 0x7F, 0x20, 0x10}}, // arrow down
+  {1, 2, {0x08, 0x1C, 0x2A, 0x08, 0x08}}, // arrow left
+  {1, 2, {0x00, 0x06, 0x01, 0x00, 0x00}}, // quote left
+  {1, 2, {0x00, 0x04, 0x03, 0x00, 0x00}}, // quote right
+  {1, 2, {0x06, 0x01, 0x00, 0x06, 0x01}}, // quotes left
+  {1, 2, {0x04, 0x03, 0x00, 0x04, 0x03}}, // quotes right
+  {1, 2, {0x00, 0x1C, 0x1C, 0x1C, 0x00}}, // bullet
+  {1, 2, {0x08, 0x08, 0x08, 0x08, 0x00}}, // en dash
+  {1, 2, {0x08, 0x08, 0x08, 0x08, 0x08}}, // em dash
+  {1, 2, {0x02, 0x01, 0x01, 0x02, 0x01}}, // small tilde
+  {1, 2, {0x71, 0x27, 0x41, 0x20, 0x70}}, // trade mark
+  {1, 2, {0x00, 0x22, 0x14, 0x08, 0x00}}, // angle right
+  {1, 2, {0x38, 0x44, 0x38, 0x54, 0x58}}, // oe
+  {1, 2, {0x08, 0x08, 0x2A, 0x1C, 0x08}}, // arrow right
+  {1, 2, {0x00, 0x00, 0x7D, 0x00, 0x00}}, // inverted !
+  {1, 2, {0x1C, 0x22, 0x7F, 0x22, 0x00}}, // cent
+  {1, 2, {0x48, 0x3E, 0x49, 0x41, 0x22}}, // pound
+  {1, 2, {0x22, 0x1C, 0x14, 0x1C, 0x22}}, // currency
+  {1, 2, {0x29, 0x2A, 0x7C, 0x2A, 0x29}}, // yen
+  {1, 2, {0x00, 0x00, 0x77, 0x00, 0x00}}, // broken bar
+  {1, 2, {0x4E, 0x55, 0x55, 0x39, 0x00}}, // section
+  {1, 2, {0x00, 0x01, 0x00, 0x01, 0x00}}, // diaeresis
+  {1, 2, {0x3E, 0x41, 0x5D, 0x55, 0x3E}}, // copyright
+  {1, 2, {0x48, 0x55, 0x55, 0x5E, 0x00}}, // ordinal a
+  {1, 2, {0x08, 0x14, 0x2A, 0x14, 0x22}}, // guillemet left
+  {1, 2, {0x04, 0x04, 0x04, 0x04, 0x1C}}, // not
+  {1, 2, {0x08, 0x08, 0x08, 0x08, 0x00}}, // soft hyphen
+  {1, 2, {0x3E, 0x4D, 0x55, 0x49, 0x3E}}, // registered
+  {1, 2, {0x01, 0x01, 0x01, 0x01, 0x01}}, // macron
+  {1, 2, {0x02, 0x05, 0x05, 0x02, 0x00}}, // degree
+  {1, 2, {0x44, 0x44, 0x5F, 0x44, 0x44}}, // plus minus
+  {1, 2, {0x00, 0x19, 0x15, 0x12, 0x00}}, // superscript 2
+  {1, 2, {0x11, 0x15, 0x15, 0x0A, 0x00}}, // superscript 3
+  {1, 2, {0x00, 0x00, 0x02, 0x01, 0x00}}, // acute
+  {1, 2, {0x7C, 0x20, 0x20, 0x10, 0x3C}}, // micro
+  {1, 2, {0x06, 0x0F, 0x7F, 0x01, 0x7F}}, // pilcrow
+  {1, 2, {0x00, 0x00, 0x08, 0x00, 0x00}}, // middle dot
+  {1, 2, {0x00, 0x40, 0x60, 0x00, 0x00}}, // cedilla
+  {1, 2, {0x00, 0x12, 0x1F, 0x10, 0x00}}, // superscript 1
+  {1, 2, {0x26, 0x29, 0x29, 0x26, 0x00}}, // ordinal o
+  {1, 2, {0x22, 0x14, 0x2A, 0x14, 0x08}}, // guillemet right
+  {1, 2, {0x17, 0x28, 0x34, 0x7A, 0x21}}, // one quarter
+  {1, 2, {0x17, 0x08, 0x44, 0x6A, 0x59}}, // one half
+  {1, 2, {0x25, 0x17, 0x28, 0x36, 0x79}}, // three quarters
+  {1, 2, {0x30, 0x48, 0x45, 0x40, 0x20}}, // inverted ?
+  {1, 2, {0x7E, 0x09, 0x7F, 0x49, 0x49}}, // AE
+  {1, 2, {0x1E, 0x21, 0x61, 0x21, 0x12}}, // C cedilla
+  {1, 2, {0x08, 0x7F, 0x49, 0x41, 0x3E}}, // ETH
+  {1, 2, {0x22, 0x14, 0x08, 0x14, 0x22}}, // multiply
+  {1, 2, {0x7E, 0x61, 0x5D, 0x43, 0x3F}}, // O stroke
+  {1, 2, {0x7F, 0x12, 0x12, 0x12, 0x0C}}, // THORN
+  {1, 2, {0x7E, 0x01, 0x49, 0x56, 0x20}}, // sharp s
+  {1, 2, {0x24, 0x54, 0x38, 0x54, 0x58}}, // ae
+  {1, 2, {0x08, 0x54, 0x74, 0x14, 0x14}}, // c cedilla
+  {1, 2, {0x20, 0x55, 0x52, 0x5D, 0x30}}, // eth
+  {1, 2, {0x08, 0x08, 0x2A, 0x08, 0x08}}, // divide
+  {1, 2, {0x38, 0x64, 0x54, 0x4C, 0x38}}, // o stroke
+  {1, 2, {0x7E, 0x24, 0x24, 0x18, 0x00}}, // thorn
+  {1, 2, {0x20, 0x54, 0x54, 0x54, 0x78}}, // a
+  {1, 2, {0x38, 0x54, 0x54, 0x54, 0x18}}, // e
+  {1, 2, {0x00, 0x44, 0x7C, 0x40, 0x00}}, // dotless i
+  {1, 2, {0x7C, 0x08, 0x04, 0x04, 0x78}}, // n
+  {1, 2, {0x38, 0x44, 0x44, 0x44, 0x38}}, // o
+  {1, 2, {0x3C, 0x40, 0x40, 0x20, 0x7C}}, // u
+  {1, 2, {0x0C, 0x50, 0x50, 0x50, 0x3C}}, // y
+  {1, 2, {0x48, 0x54, 0x54, 0x54, 0x24}}, // s
+  {1, 2, {0x44, 0x64, 0x54, 0x4C, 0x44}}, // z
+  {3, 2, {0x3E, 0x09, 0x09, 0x09, 0x3E}}, // A (upper case)
+  {3, 2, {0x3F, 0x25, 0x25, 0x25, 0x21}}, // E (upper case)
+  {3, 2, {0x00, 0x21, 0x3F, 0x21, 0x00}}, // I (upper case)
+  {3, 2, {0x3F, 0x02, 0x04, 0x08, 0x3F}}, // N (upper case)
+  {3, 2, {0x1E, 0x21, 0x21, 0x21, 0x1E}}, // O (upper case)
+  {3, 2, {0x1F, 0x20, 0x20, 0x20, 0x1F}}, // U (upper case)
+  {3, 2, {0x03, 0x04, 0x38, 0x04, 0x03}}, // Y (upper case)
+  {3, 2, {0x22, 0x25, 0x25, 0x25, 0x19}}, // S (upper case)
+  {3, 2, {0x31, 0x29, 0x25, 0x23, 0x21}}, // Z (upper case)
+  {0, 1, {0x00, 0x01, 0x02, 0x00, 0x00}}, // grave accent
+  {0, 1, {0x00, 0x00, 0x02, 0x01, 0x00}}, // acute accent
+  {0, 1, {0x00, 0x02, 0x01, 0x02, 0x00}}, // circumflex accent
+  {0, 1, {0x02, 0x01, 0x01, 0x02, 0x01}}, // tilde accent
+  {0, 1, {0x00, 0x03, 0x00, 0x03, 0x00}}, // diaeresis accent
+  {0, 1, {0x00, 0x02, 0x05, 0x02, 0x00}}, // ring accent
+  {0, 1, {0x00, 0x01, 0x02, 0x01, 0x00}}, // caron accent
+};
+
+// the characters 128 - 255: shape, accent (0 = none) and the
+// pixel row of the accent
+static const tb_display_charset_char charset_chars[128] = {
+  {1, 0, 0}, // 0x80 euro
+  {2, 0, 0}, // 0x81 ohm
+  {3, 0, 0}, // 0x82 quote low
+  {4, 0, 0}, // 0x83 florin
+  {5, 0, 0}, // 0x84 quotes low
+  {6, 0, 0}, // 0x85 ellipsis
+  {7, 0, 0}, // 0x86 dagger
+  {8, 0, 0}, // 0x87 double dagger
+  {9, 0, 0}, // 0x88 circumflex
+  {10, 0, 0}, // 0x89 per mille
+  {88, 96, 0}, // 0x8A S caron
+  {11, 0, 0}, // 0x8B angle left
+  {12, 0, 0}, // 0x8C OE
+  {13, 0, 0}, // 0x8D arrow up
+  {89, 96, 0}, // 0x8E Z caron
+  {14, 0, 0}, // 0x8F arrow down
+  {15, 0, 0}, // 0x90 arrow left
+  {16, 0, 0}, // 0x91 quote left
+  {17, 0, 0}, // 0x92 quote right
+  {18, 0, 0}, // 0x93 quotes left
+  {19, 0, 0}, // 0x94 quotes right
+  {20, 0, 0}, // 0x95 bullet
+  {21, 0, 0}, // 0x96 en dash
+  {22, 0, 0}, // 0x97 em dash
+  {23, 0, 0}, // 0x98 small tilde
+  {24, 0, 0}, // 0x99 trade mark
+  {79, 96, 1}, // 0x9A s caron
+  {25, 0, 0}, // 0x9B angle right
+  {26, 0, 0}, // 0x9C oe
+  {27, 0, 0}, // 0x9D arrow right
+  {80, 96, 1}, // 0x9E z caron
+  {87, 94, 0}, // 0x9F Y diaeresis
+  {0, 0, 0}, // 0xA0 no-break space
+  {28, 0, 0}, // 0xA1 inverted !
+  {29, 0, 0}, // 0xA2 cent
+  {30, 0, 0}, // 0xA3 pound
+  {31, 0, 0}, // 0xA4 currency
+  {32, 0, 0}, // 0xA5 yen
+  {33, 0, 0}, // 0xA6 broken bar
+  {34, 0, 0}, // 0xA7 section
+  {35, 0, 0}, // 0xA8 diaeresis
+  {36, 0, 0}, // 0xA9 copyright
+  {37, 0, 0}, // 0xAA ordinal a
+  {38, 0, 0}, // 0xAB guillemet left
+  {39, 0, 0}, // 0xAC not
+  {40, 0, 0}, // 0xAD soft hyphen
+  {41, 0, 0}, // 0xAE registered
+  {42, 0, 0}, // 0xAF macron
+  {43, 0, 0}, // 0xB0 degree
+  {44, 0, 0}, // 0xB1 plus minus
+  {45, 0, 0}, // 0xB2 superscript 2
+  {46, 0, 0}, // 0xB3 superscript 3
+  {47, 0, 0}, // 0xB4 acute
+  {48, 0, 0}, // 0xB5 micro
+  {49, 0, 0}, // 0xB6 pilcrow
+  {50, 0, 0}, // 0xB7 middle dot
+  {51, 0, 0}, // 0xB8 cedilla
+  {52, 0, 0}, // 0xB9 superscript 1
+  {53, 0, 0}, // 0xBA ordinal o
+  {54, 0, 0}, // 0xBB guillemet right
+  {55, 0, 0}, // 0xBC one quarter
+  {56, 0, 0}, // 0xBD one half
+  {57, 0, 0}, // 0xBE three quarters
+  {58, 0, 0}, // 0xBF inverted ?
+  {81, 90, 0}, // 0xC0 A grave
+  {81, 91, 0}, // 0xC1 A acute
+  {81, 92, 0}, // 0xC2 A circumflex
+  {81, 93, 0}, // 0xC3 A tilde
+  {81, 94, 0}, // 0xC4 A diaeresis
+  {81, 95, 0}, // 0xC5 A ring
+  {59, 0, 0}, // 0xC6 AE
+  {60, 0, 0}, // 0xC7 C cedilla
+  {82, 90, 0}, // 0xC8 E grave
+  {82, 91, 0}, // 0xC9 E acute
+  {82, 92, 0}, // 0xCA E circumflex
+  {82, 94, 0}, // 0xCB E diaeresis
+  {83, 90, 0}, // 0xCC I grave
+  {83, 91, 0}, // 0xCD I acute
+  {83, 92, 0}, // 0xCE I circumflex
+  {83, 94, 0}, // 0xCF I diaeresis
+  {61, 0, 0}, // 0xD0 ETH
+  {84, 93, 0}, // 0xD1 N tilde
+  {85, 90, 0}, // 0xD2 O grave
+  {85, 91, 0}, // 0xD3 O acute
+  {85, 92, 0}, // 0xD4 O circumflex
+  {85, 93, 0}, // 0xD5 O tilde
+  {85, 94, 0}, // 0xD6 O diaeresis
+  {62, 0, 0}, // 0xD7 multiply
+  {63, 0, 0}, // 0xD8 O stroke
+  {86, 90, 0}, // 0xD9 U grave
+  {86, 91, 0}, // 0xDA U acute
+  {86, 92, 0}, // 0xDB U circumflex
+  {86, 94, 0}, // 0xDC U diaeresis
+  {87, 91, 0}, // 0xDD Y acute
+  {64, 0, 0}, // 0xDE THORN
+  {65, 0, 0}, // 0xDF sharp s
+  {72, 90, 1}, // 0xE0 a grave
+  {72, 91, 1}, // 0xE1 a acute
+  {72, 92, 1}, // 0xE2 a circumflex
+  {72, 93, 1}, // 0xE3 a tilde
+  {72, 94, 1}, // 0xE4 a diaeresis
+  {72, 95, 1}, // 0xE5 a ring
+  {66, 0, 0}, // 0xE6 ae
+  {67, 0, 0}, // 0xE7 c cedilla
+  {73, 90, 1}, // 0xE8 e grave
+  {73, 91, 1}, // 0xE9 e acute
+  {73, 92, 1}, // 0xEA e circumflex
+  {73, 94, 1}, // 0xEB e diaeresis
+  {74, 90, 1}, // 0xEC i grave
+  {74, 91, 1}, // 0xED i acute
+  {74, 92, 1}, // 0xEE i circumflex
+  {74, 94, 1}, // 0xEF i diaeresis
+  {68, 0, 0}, // 0xF0 eth
+  {75, 93, 1}, // 0xF1 n tilde
+  {76, 90, 1}, // 0xF2 o grave
+  {76, 91, 1}, // 0xF3 o acute
+  {76, 92, 1}, // 0xF4 o circumflex
+  {76, 93, 1}, // 0xF5 o tilde
+  {76, 94, 1}, // 0xF6 o diaeresis
+  {69, 0, 0}, // 0xF7 divide
+  {70, 0, 0}, // 0xF8 o stroke
+  {77, 90, 1}, // 0xF9 u grave
+  {77, 91, 1}, // 0xFA u acute
+  {77, 92, 1}, // 0xFB u circumflex
+  {77, 94, 1}, // 0xFC u diaeresis
+  {78, 91, 1}, // 0xFD y acute
+  {71, 0, 0}, // 0xFE thorn
+  {78, 94, 1}, // 0xFF y diaeresis
+};
+
+// the codepoints of the characters 128 - 159
+static const uint16_t charset_symbols[32] = {
+  0x20AC, 0x03A9, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, // 128 - 135
+  0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x2191, 0x017D, 0x2193, // 136 - 143
+  0x2190, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, // 144 - 151
+  0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x2192, 0x017E, 0x0178, // 152 - 159
+};
+
+// =============================================================
+// the extended character of a Unicode codepoint
+// =============================================================
+uint8_t tb_display_charset_code(uint32_t codepoint){
+  // Latin-1
+  if(codepoint >= 0xA0 && codepoint <= 0xFF)
+    return codepoint;
+  // characters with the same look
+  if(codepoint == 0x2126) // ohm sign
+    return 0x81;
+  if(codepoint == 0x03BC) // greek small letter mu
+    return 0xB5;
+  for(int n = 0; n < 32; n++){
+    if(charset_symbols[n] == codepoint)
+      return 0x80 + n;
+  }
+  return 0;
+}
+
+// =============================================================
+// the columns of a character (shape and accent together)
+// returns the first column that is not empty
+// (5 = the character is empty)
+// =============================================================
+static int tb_display_charset_columns(uint16_t c, int *last){
+  const tb_display_charset_char *ch = &charset_chars[c-128];
+  int first = 5;
+  *last = -1;
+  for(int col = 0; col < 5; col++){
+    if(charset_shapes[ch->shape].columns[col] != 0 || charset_shapes[ch->accent].columns[col] != 0){
+      if(first == 5)
+        first = col;
+      *last = col;
+    }
+  }
+  return first;
+}
+
+// =============================================================
+// width of an extended character
+// (the spacing like the 5x7 font: one pixel in front of the
+// character and one behind it)
+// =============================================================
+int16_t tb_display_charset_width(uint16_t c){
+  if(c < 128 || c > 255)
+    return 0;
+  int last;
+  int first = tb_display_charset_columns(c, &last);
+  // an empty character has the width of a space
+  if(first == 5)
+    return 4;
+  return last - first + 3;
+}
+
+// =============================================================
+// draw a shape with the columns from "first" at x, y
+// =============================================================
+static void tb_display_charset_shape_draw(uint16_t *pixels, int32_t w, int32_t h,
+                                          const tb_display_charset_shape *shape, int first,
+                                          int32_t x, int32_t y, uint16_t color){
+  for(int col = first; col < 5; col++){
+    int32_t px = x + col - first;
+    if(px < 0 || px >= w)
+      continue;
+    for(int bit = 0; bit < 8; bit++){
+      if((shape->columns[col] & (1 << bit)) == 0)
+        continue;
+      for(int row = 0; row < shape->height; row++){
+        int32_t py = y + shape->y + shape->height*bit + row;
+        if(py >= 0 && py < h)
+          pixels[py*w + px] = color;
+      }
+    }
+  }
+}
+
+// =============================================================
+// draw an extended character into a pixel buffer
+// =============================================================
+int16_t tb_display_charset_draw(uint16_t *pixels, int32_t w, int32_t h,
+                                uint16_t c, int32_t x, int32_t y, uint16_t color){
+  int16_t width = tb_display_charset_width(c);
+  if(width == 0 || pixels == NULL)
+    return width;
+  const tb_display_charset_char *ch = &charset_chars[c-128];
+  int last;
+  int first = tb_display_charset_columns(c, &last);
+  if(first == 5)
+    return width;
+  // the empty columns on the left side are skipped
+  tb_display_charset_shape_draw(pixels, w, h, &charset_shapes[ch->shape], first, x + 1, y, color);
+  if(ch->accent != 0)
+    tb_display_charset_shape_draw(pixels, w, h, &charset_shapes[ch->accent], first, x + 1, y + ch->accent_y, color);
+  return width;
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * tb_display_charset.h
+ * Extended characters of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The text buffer keeps one byte per character. The characters
+ * 32 - 127 are ASCII and drawn with the font of the backend.
+ * The characters 128 - 255 are the extended characters:
+ *   160 - 255 = Latin-1 (U+00A0 - U+00FF), e.g. ° µ ² ä ö ü ß é
+ *   128 - 159 = the symbols of Windows-1252 (€ … • – — ™ ‰ Š Œ Ž ...)
+ *               and in its unused codes: Ω and the arrows ↑ ↓ ← →
+ * The UTF-8 text is decoded by tb_display_print_char into these
+ * characters (see tb_display_utf8 in tb_display.h). Other characters
+ * are shown as '?'.
+ *
+ * The extended characters are drawn by the backends with the font of
+ * this file: 5 columns and 8 rows, each row two pixel high, like the
+ * 5x7 font of the framebuffer backend. The font is stored compressed
+ * in the flash: a character is a shape and an optional accent (most
+ * Latin-1 letters share their base letter with other characters).
+ * A character is found with one table access.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_CHARSET_H
+#define TB_DISPLAY_CHARSET_H
+
+#include <stdint.h>
+
+// =============================================================
+//           tb_display_charset_code(codepoint);
+// the extended character (128 - 255) of a Unicode codepoint
+// returns 0 if the codepoint has no extended character
+// =============================================================
+uint8_t tb_display_charset_code(uint32_t codepoint);
+
+// =============================================================
+//           tb_display_charset_width(c);
+// width of the extended character c (128 - 255) in pixel
+// including the spacing to the next character
+// returns 0 for other characters
+// =============================================================
+int16_t tb_display_charset_width(uint16_t c);
+
+// =============================================================
+//           tb_display_charset_draw(pixels, w, h, c, x, y, color);
+// draw the extended character c into a pixel buffer of the size
+// w x h at the position x, y (top left corner of the text row)
+// Only the pixels of the character are set, the background
+// is not changed. Pixels outside of the buffer are skipped.
+// returns the width of the character
+// =============================================================
+int16_t tb_display_charset_draw(uint16_t *pixels, int32_t w, int32_t h,
+                                uint16_t c, int32_t x, int32_t y, uint16_t color);
+
+#endif // TB_DISPLAY_CHARSET_H
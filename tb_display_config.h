@@ -0,0 +1,200 @@
+/******************************************************************************
+ * tb_display_config.h
+ * Compile time configuration of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The type of M5Stick is chosen here. It can also be set from outside
+ * with a build flag (e.g. -D M5STICKC in platformio.ini).
+ * The type defines the screen size and the size of the text buffer.
+ *
+ * With the build flag TB_DISPLAY_HOST, the library is compiled without
+ * the Arduino framework (e.g. on a Linux host). Then, the in-memory
+ * framebuffer is used as display backend.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_CONFIG_H
+#define TB_DISPLAY_CONFIG_H
+
+// Choose the type of M5Stick here:
+// #define M5STICKC
+// #define M5STICKCPLUS
+#if !defined(M5STICKC) && !defined(M5STICKCPLUS)
+  #define M5STICKCPLUS
+#endif
+
+// TextSize 1 is very small on the display = hard to read
+// Textsize 2 is good readable without the need of an microscope.
+// This code only runs with text size 2!
+#define TEXT_SIZE 2
+#define TEXT_HEIGHT 16 // Height of text to be printed
+// Display size of M5StickC     = 160x80
+// Display size of M5StickCPlus = 240*135
+// With TEXT_HEIGHT=16, the screen can display:
+// M5StickC:
+//    5 rows of text in portrait mode
+//   10 rows of text in landscape mode
+// M5StcikCPlus:
+//    8 rows of text in portrait mode
+//   15 rows of text in landscape mode
+
+// M5StickC:
+// Display size of M5StickC = 160x80
+// screen buffer for 10 rows of 60 characters max.
+#ifdef M5STICKC
+  #define SCREEN_WIDTH 160
+  #define SCREEN_HEIGHT 80
+  #define TEXT_BUFFER_HEIGHT_WIDE 10
+  #define TEXT_BUFFER_HEIGHT_NARROW 5
+  #define TEXT_BUFFER_LINE_LENGTH_WIDE 60
+  #define TEXT_BUFFER_LINE_LENGTH_NARROW 30
+  #define TB_DISPLAY_BOARD_BACKEND tb_display_backend_m5stickc
+#endif
+// M5StickCPlus:
+// Display size of M5StickCPlus = 240*135
+// screen buffer for 15 rows of 90 characters max.
+#ifdef M5STICKCPLUS
+  #define SCREEN_WIDTH 240
+  #define SCREEN_HEIGHT 135
+  #define TEXT_BUFFER_HEIGHT_WIDE 15
+  #define TEXT_BUFFER_HEIGHT_NARROW 8
+  #define TEXT_BUFFER_LINE_LENGTH_WIDE 90
+  #define TEXT_BUFFER_LINE_LENGTH_NARROW 45
+  #define TB_DISPLAY_BOARD_BACKEND tb_display_backend_m5stickcplus
+#endif
+
+// memory for the off-screen sprite of the row sprite mode (in bytes)
+// A sprite for a full text row needs SCREEN_WIDTH*TEXT_HEIGHT*2 bytes
+// (M5StickC: 5120 bytes, M5StickCPlus: 7680 bytes)
+// With less memory, the rows are pushed in several parts.
+#ifndef TB_DISPLAY_SPRITE_BUDGET
+  #define TB_DISPLAY_SPRITE_BUDGET (SCREEN_WIDTH*TEXT_HEIGHT*2)
+#endif
+
+// memory of the glyph cache (in bytes, 0 = no cache)
+// The cached characters are copied to the screen instead of being
+// drawn from the font. A character of the font 2 needs about
+// 8*TEXT_HEIGHT*2 bytes for each color variant.
+#ifndef TB_DISPLAY_GLYPH_CACHE_BYTES
+  #define TB_DISPLAY_GLYPH_CACHE_BYTES 16384
+#endif
+// maximum number of color variants in the glyph cache
+#ifndef TB_DISPLAY_GLYPH_VARIANTS
+  #define TB_DISPLAY_GLYPH_VARIANTS 4
+#endif
+
+// size of the scrollback history
+// maximum number of rows in the history (0 = no history)
+#ifndef TB_DISPLAY_SCROLLBACK_LINES
+  #define TB_DISPLAY_SCROLLBACK_LINES 2048
+#endif
+// memory for the characters of the rows (in bytes, 0 = no history)
+// A row needs the number of characters + 2 bytes, the memory must
+// hold at least one row of TEXT_BUFFER_LINE_LENGTH_WIDE characters.
+#ifndef TB_DISPLAY_SCROLLBACK_BYTES
+  #define TB_DISPLAY_SCROLLBACK_BYTES 32768
+#endif
+
+// size of the input queue of tb_display_queue_push (in characters)
+// must be a power of 2
+#ifndef TB_DISPLAY_QUEUE_SIZE
+  #define TB_DISPLAY_QUEUE_SIZE 1024
+#endif
+// the render task runs on the other core than the loop() (core 1)
+#ifndef TB_DISPLAY_RENDER_CORE
+  #define TB_DISPLAY_RENDER_CORE 0
+#endif
+#ifndef TB_DISPLAY_RENDER_PRIORITY
+  #define TB_DISPLAY_RENDER_PRIORITY 1
+#endif
+// stack size of the render task (in bytes)
+#ifndef TB_DISPLAY_RENDER_STACK
+  #define TB_DISPLAY_RENDER_STACK 4096
+#endif
+
+// size of the typewriter queue of tb_display_type_String
+// memory for the characters of the waiting strings (in bytes)
+#ifndef TB_DISPLAY_TYPEWRITER_BYTES
+  #define TB_DISPLAY_TYPEWRITER_BYTES 512
+#endif
+// maximum number of waiting strings
+#ifndef TB_DISPLAY_TYPEWRITER_STRINGS
+  #define TB_DISPLAY_TYPEWRITER_STRINGS 8
+#endif
+
+// polling of the Keyboard-Hat (see tb_display_keyboard.h)
+// I2C address of the Keyboard-Hat (CardKB)
+#ifndef TB_DISPLAY_CARDKB_ADDR
+  #define TB_DISPLAY_CARDKB_ADDR 0x5F
+#endif
+// poll interval while keys are typed (in milliseconds)
+#ifndef TB_DISPLAY_KEYBOARD_FAST_MS
+  #define TB_DISPLAY_KEYBOARD_FAST_MS 10
+#endif
+// longest poll interval when nobody is typing (in milliseconds)
+#ifndef TB_DISPLAY_KEYBOARD_SLOW_MS
+  #define TB_DISPLAY_KEYBOARD_SLOW_MS 160
+#endif
+// time without keys before the interval grows (in milliseconds)
+#ifndef TB_DISPLAY_KEYBOARD_ACTIVE_MS
+  #define TB_DISPLAY_KEYBOARD_ACTIVE_MS 2000
+#endif
+// number of keys waiting to be read
+#ifndef TB_DISPLAY_KEYBOARD_QUEUE
+  #define TB_DISPLAY_KEYBOARD_QUEUE 16
+#endif
+
+// maximum number of characters of a line of the line editor
+// (see tb_display_edit_key)
+#ifndef TB_DISPLAY_EDIT_LENGTH
+  #define TB_DISPLAY_EDIT_LENGTH 128
+#endif
+
+// pinned status fields above the scrolling text
+// (see tb_display_status_field)
+// number of fields and maximum characters of a field
+#ifndef TB_DISPLAY_STATUS_FIELDS
+  #define TB_DISPLAY_STATUS_FIELDS 4
+#endif
+#ifndef TB_DISPLAY_STATUS_LENGTH
+  #define TB_DISPLAY_STATUS_LENGTH 16
+#endif
+
+// snapshot of the screen rows in the RTC memory for the deep sleep
+// (see tb_display_snapshot.h), in bytes
+// The ESP32 has 8KB RTC slow memory. The snapshot needs 14 bytes
+// and 2 bytes per row, 1 byte per character and 1 byte per
+// character of a row with colors.
+#ifndef TB_DISPLAY_SNAPSHOT_BYTES
+  #define TB_DISPLAY_SNAPSHOT_BYTES 2048
+#endif
+
+// mirror of the text buffer over a serial port (see tb_display_mirror.h)
+// maximum size of a frame (in bytes)
+// A frame must hold a row where every character has other colors.
+#ifndef TB_DISPLAY_MIRROR_FRAME_BYTES
+  #define TB_DISPLAY_MIRROR_FRAME_BYTES 512
+#endif
+// the whole text buffer is sent again after this time, so a host
+// that starts later or has lost a frame gets in sync
+// (in milliseconds, 0 = only at the start and after a rotation)
+#ifndef TB_DISPLAY_MIRROR_KEY_MS
+  #define TB_DISPLAY_MIRROR_KEY_MS 5000
+#endif
+
+// counters and timing of the drawing (see tb_display_stats.h)
+// 0 = the counting is removed from the library
+#ifndef TB_DISPLAY_STATS
+  #define TB_DISPLAY_STATS 1
+#endif
+
+// the backend used after startup
+// on a host, there is no LCD: use the in-memory framebuffer
+#ifdef TB_DISPLAY_HOST
+  #define TB_DISPLAY_DEFAULT_BACKEND tb_display_backend_framebuffer
+#else
+  #define TB_DISPLAY_DEFAULT_BACKEND TB_DISPLAY_BOARD_BACKEND
+#endif
+
+#endif // TB_DISPLAY_CONFIG_H
@@ -0,0 +1,403 @@
+/******************************************************************************
+ * tb_display_framebuffer.cpp
+ * RGB565 in-memory framebuffer backend for the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The framebuffer has the screen size of the chosen M5Stick type.
+ * It has no LCD attached. The frames can be written as PPM files.
+ * This allows to run and profile the text buffer on a Linux host.
+ *
+ * The characters are drawn with a 5x7 pixel font, doubled in height.
+ * So a character fits in the same 16 pixel high text rows as the
+ * font 2 on the M5Stick.
+ * The characters 128 - 255 are drawn with the extended font
+ * (tb_display_charset.h), that has the same design.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "tb_display_backend.h"
+#include "tb_display_charset.h"
+#include "tb_display_glyph_cache.h"
+
+// 5x7 pixel font for the characters 32 - 127
+// one byte per column, bit 0 = top row
+static const uint8_t fb_font[96][5] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00}, // space
+  {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
+  {0x00, 0x07, 0x00, 0x07, 0x00}, // "
+  {0x14, 0x7F, 0x14, 0x7F, 0x14}, // #
+  {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // $
+  {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+  {0x36, 0x49, 0x55, 0x22, 0x50}, // &
+  {0x00, 0x05, 0x03, 0x00, 0x00}, // '
+  {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
+  {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
+  {0x08, 0x2A, 0x1C, 0x2A, 0x08}, // *
+  {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
+  {0x00, 0x50, 0x30, 0x00, 0x00}, // ,
+  {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+  {0x00, 0x60, 0x60, 0x00, 0x00}, // .
+  {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+  {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+  {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+  {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
+  {0x21, 0x41, 0x45, 0x4B, 0x31}, // 3
+  {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+  {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+  {0x3C, 0x4A, 0x49, 0x49, 0x30}, // 6
+  {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
+  {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+  {0x06, 0x49, 0x49, 0x29, 0x1E}, // 9
+  {0x00, 0x36, 0x36, 0x00, 0x00}, // :
+  {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
+  {0x08, 0x14, 0x22, 0x41, 0x00}, // <
+  {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+  {0x00, 0x41, 0x22, 0x14, 0x08}, // >
+  {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
+  {0x32, 0x49, 0x79, 0x41, 0x3E}, // @
+  {0x7E, 0x11, 0x11, 0x11, 0x7E}, // A
+  {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
+  {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
+  {0x7F, 0x41, 0x41, 0x22, 0x1C}, // D
+  {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
+  {0x7F, 0x09, 0x09, 0x01, 0x01}, // F
+  {0x3E, 0x41, 0x41, 0x51, 0x32}, // G
+  {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
+  {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
+  {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
+  {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
+  {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
+  {0x7F, 0x02, 0x04, 0x02, 0x7F}, // M
+  {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
+  {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+  {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
+  {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
+  {0x46, 0x49, 0x49, 0x49, 0x31}, // S
+  {0x01, 0x01, 0x7F, 0x01, 0x01}, // T
+  {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
+  {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
+  {0x7F, 0x20, 0x18, 0x20, 0x7F}, // W
+  {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+  {0x03, 0x04, 0x78, 0x04, 0x03}, // Y
+  {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
+  {0x00, 0x7F, 0x41, 0x41, 0x00}, // [
+  {0x02, 0x04, 0x08, 0x10, 0x20}, // backslash
+  {0x00, 0x41, 0x41, 0x7F, 0x00}, // ]
+  {0x04, 0x02, 0x01, 0x02, 0x04}, // ^
+  {0x40, 0x40, 0x40, 0x40, 0x40}, // _
+  {0x00, 0x01, 0x02, 0x04, 0x00}, // `
+  {0x20, 0x54, 0x54, 0x54, 0x78}, // a
+  {0x7F, 0x48, 0x44, 0x44, 0x38}, // b
+  {0x38, 0x44, 0x44, 0x44, 0x20}, // c
+  {0x38, 0x44, 0x44, 0x48, 0x7F}, // d
+  {0x38, 0x54, 0x54, 0x54, 0x18}, // e
+  {0x08, 0x7E, 0x09, 0x01, 0x02}, // f
+  {0x08, 0x14, 0x54, 0x54, 0x3C}, // g
+  {0x7F, 0x08, 0x04, 0x04, 0x78}, // h
+  {0x00, 0x44, 0x7D, 0x40, 0x00}, // i
+  {0x20, 0x40, 0x44, 0x3D, 0x00}, // j
+  {0x00, 0x7F, 0x10, 0x28, 0x44}, // k
+  {0x00, 0x41, 0x7F, 0x40, 0x00}, // l
+  {0x7C, 0x04, 0x18, 0x04, 0x78}, // m
+  {0x7C, 0x08, 0x04, 0x04, 0x78}, // n
+  {0x38, 0x44, 0x44, 0x44, 0x38}, // o
+  {0x7C, 0x14, 0x14, 0x14, 0x08}, // p
+  {0x08, 0x14, 0x14, 0x18, 0x7C}, // q
+  {0x7C, 0x08, 0x04, 0x04, 0x08}, // r
+  {0x48, 0x54, 0x54, 0x54, 0x20}, // s
+  {0x04, 0x3F, 0x44, 0x40, 0x20}, // t
+  {0x3C, 0x40, 0x40, 0x20, 0x7C}, // u
+  {0x1C, 0x20, 0x40, 0x20, 0x1C}, // v
+  {0x3C, 0x40, 0x30, 0x40, 0x3C}, // w
+  {0x44, 0x28, 0x10, 0x28, 0x44}, // x
+  {0x0C, 0x50, 0x50, 0x50, 0x3C}, // y
+  {0x44, 0x64, 0x54, 0x4C, 0x44}, // z
+  {0x00, 0x08, 0x36, 0x41, 0x00}, // {
+  {0x00, 0x00, 0x7F, 0x00, 0x00}, // |
+  {0x00, 0x41, 0x36, 0x08, 0x00}, // }
+  {0x08, 0x04, 0x08, 0x10, 0x08}, // ~
+  {0x00, 0x00, 0x00, 0x00, 0x00}, // DEL
+};
+
+// width of each character including the spacing to the next character
+static constexpr uint8_t fb_font_width[96] = {
+  4, 3, 5, 7, 7, 7, 7, 4, 5, 5, 7, 7, 4, 7, 4, 7,  // 32 - 47
+  7, 5, 7, 7, 7, 7, 7, 7, 7, 7, 4, 4, 6, 7, 6, 7,  // 48 - 63
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 5, 7, 7, 7, 7, 7, 7,  // 64 - 79
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 5, 7, 5, 7, 7,  // 80 - 95
+  5, 7, 7, 7, 7, 7, 7, 7, 7, 5, 6, 6, 5, 7, 7, 7,  // 96 - 111
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 5, 3, 5, 7, 4,  // 112 - 127
+};
+
+static uint16_t *fb_pixels = NULL;
+// size of the framebuffer with the actual rotation
+static int fb_width = SCREEN_WIDTH;
+static int fb_height = SCREEN_HEIGHT;
+static uint16_t fb_text_color = TFT_WHITE;
+// same color as the text color: no background
+static uint16_t fb_text_bgcolor = TFT_WHITE;
+// emulated scroll offset register (only used in portrait mode)
+static int fb_scroll_offset = 0;
+
+static void fb_set_rotation(int rotation){
+  if(fb_pixels == NULL)
+    fb_pixels = (uint16_t*)calloc(SCREEN_WIDTH*SCREEN_HEIGHT, sizeof(uint16_t));
+  // 1 and 3 = landscape mode
+  if(rotation & 1){
+    fb_width = SCREEN_WIDTH;
+    fb_height = SCREEN_HEIGHT;
+  } else {
+    fb_width = SCREEN_HEIGHT;
+    fb_height = SCREEN_WIDTH;
+  }
+  fb_scroll_offset = 0;
+}
+
+static void fb_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color){
+  if(fb_pixels == NULL)
+    return;
+  // clip to the screen
+  if(x < 0) { w += x; x = 0; }
+  if(y < 0) { h += y; y = 0; }
+  if(x + w > fb_width) w = fb_width - x;
+  if(y + h > fb_height) h = fb_height - y;
+  for(int32_t row = y; row < y + h; row++){
+    uint16_t *p = fb_pixels + row*fb_width + x;
+    for(int32_t n = 0; n < w; n++)
+      p[n] = color;
+  }
+}
+
+static void fb_fill_screen(uint16_t color){
+  fb_fill_rect(0, 0, fb_width, fb_height, color);
+}
+
+static int16_t fb_char_width(uint16_t c, uint8_t font){
+  (void)font;
+  if(c < 32 || c > 255)
+    return 0;
+  if(c > 127)
+    return tb_display_charset_width(c);
+  return fb_font_width[c-32];
+}
+
+// draw a character into a pixel buffer of the size w x h
+static int16_t fb_draw_glyph(uint16_t *pixels, int32_t w, int32_t h,
+                             uint16_t c, int32_t x, int32_t y){
+  int16_t width = fb_char_width(c, TEXT_SIZE);
+  if(width == 0)
+    return 0;
+  if(pixels != NULL && fb_text_bgcolor != fb_text_color){
+    // the background of the character (like the font 2 on the LCD)
+    for(int32_t py = y; py < y + TEXT_HEIGHT && py < h; py++){
+      for(int32_t px = x; px < x + width && px < w; px++){
+        if(px >= 0 && py >= 0)
+          pixels[py*w + px] = fb_text_bgcolor;
+      }
+    }
+  }
+  if(c > 127)
+    return tb_display_charset_draw(pixels, w, h, c, x, y, fb_text_color);
+  const uint8_t *glyph = fb_font[c-32];
+  if(pixels != NULL){
+    // skip the empty columns on the left side
+    int first = 0;
+    while(first < 5 && glyph[first] == 0)
+      first++;
+    for(int col = first; col < 5; col++){
+      int32_t px = x + 1 + col - first;
+      if(px < 0 || px >= w)
+        continue;
+      for(int bit = 0; bit < 7; bit++){
+        if(glyph[col] & (1 << bit)){
+          // each font row is two pixel high
+          int32_t py = y + 1 + 2*bit;
+          if(py >= 0 && py+1 < h){
+            pixels[py*w + px] = fb_text_color;
+            pixels[(py+1)*w + px] = fb_text_color;
+          }
+        }
+      }
+    }
+  }
+  return width;
+}
+
+// render a character for the glyph cache
+// The rows are erased black before the characters are drawn, so
+// a character without background is rendered on black.
+static void fb_render_glyph(uint16_t *pixels, uint16_t c, int width,
+                            uint16_t color, uint16_t bgcolor){
+  for(int32_t n = 0; n < width*TEXT_HEIGHT; n++)
+    pixels[n] = bgcolor == color ? TFT_BLACK : bgcolor;
+  fb_draw_glyph(pixels, width, TEXT_HEIGHT, c, 0, 0);
+}
+
+// draw a character into a pixel buffer of the size w x h
+// copied from the glyph cache, if possible
+// (the cache keeps only the characters 32 - 127)
+static int16_t fb_draw_cached(uint16_t *pixels, int32_t w, int32_t h,
+                              uint16_t c, int32_t x, int32_t y){
+  if(c > 127)
+    return fb_draw_glyph(pixels, w, h, c, x, y);
+  if(c < 32)
+    return 0;
+  int width = fb_font_width[c-32];
+  const uint16_t *glyph = tb_display_glyph_cache_get(c, width, fb_text_color,
+                                                     fb_text_bgcolor, fb_render_glyph);
+  if(glyph == NULL || pixels == NULL)
+    return fb_draw_glyph(pixels, w, h, c, x, y);
+  for(int32_t row = 0; row < TEXT_HEIGHT; row++){
+    if(y+row < 0 || y+row >= h)
+      continue;
+    for(int32_t col = 0; col < width; col++){
+      if(x+col >= 0 && x+col < w)
+        pixels[(y+row)*w + x+col] = glyph[row*width + col];
+    }
+  }
+  return width;
+}
+
+static int16_t fb_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  (void)font;
+  return fb_draw_cached(fb_pixels, fb_width, fb_height, c, x, y);
+}
+
+// like the LCD controller, the display memory can only be scrolled
+// along the long side of the screen = in portrait mode
+static bool fb_scroll_init(int rotation){
+  fb_scroll_offset = 0;
+  return (rotation & 1) == 0;
+}
+
+static void fb_scroll_to(int32_t offset){
+  fb_scroll_offset = offset % fb_height;
+  if(fb_scroll_offset < 0)
+    fb_scroll_offset += fb_height;
+}
+
+// the row sprite is a second small pixel buffer
+static uint16_t *fb_sprite = NULL;
+static int32_t fb_sprite_width = 0;
+static int32_t fb_sprite_height = 0;
+
+static bool fb_sprite_create(int32_t w, int32_t h){
+  if(w == fb_sprite_width && h == fb_sprite_height)
+    return true;
+  free(fb_sprite);
+  fb_sprite = (uint16_t*)calloc(w*h, sizeof(uint16_t));
+  if(fb_sprite == NULL){
+    fb_sprite_width = 0;
+    fb_sprite_height = 0;
+    return false;
+  }
+  fb_sprite_width = w;
+  fb_sprite_height = h;
+  return true;
+}
+
+static void fb_sprite_fill(uint16_t color){
+  for(int32_t n = 0; n < fb_sprite_width*fb_sprite_height; n++)
+    fb_sprite[n] = color;
+}
+
+static int16_t fb_sprite_draw_char(uint16_t c, int32_t x, int32_t y, uint8_t font){
+  (void)font;
+  return fb_draw_cached(fb_sprite, fb_sprite_width, fb_sprite_height, c, x, y);
+}
+
+static void fb_set_text_color(uint16_t color, uint16_t bgcolor){
+  fb_text_color = color;
+  fb_text_bgcolor = bgcolor;
+}
+
+static void fb_sprite_push(int32_t x, int32_t y){
+  if(fb_pixels == NULL)
+    return;
+  for(int32_t row = 0; row < fb_sprite_height; row++){
+    if(y+row < 0 || y+row >= fb_height)
+      continue;
+    for(int32_t col = 0; col < fb_sprite_width; col++){
+      if(x+col >= 0 && x+col < fb_width)
+        fb_pixels[(y+row)*fb_width + x+col] = fb_sprite[row*fb_sprite_width + col];
+    }
+  }
+}
+
+const tb_display_backend tb_display_backend_framebuffer = {
+  "Framebuffer",
+  SCREEN_WIDTH,
+  SCREEN_HEIGHT,
+  fb_set_rotation,
+  fb_fill_screen,
+  fb_fill_rect,
+  fb_draw_char,
+  fb_char_width,
+  fb_font_width,
+  fb_scroll_init,
+  fb_scroll_to,
+  fb_sprite_create,
+  fb_sprite_fill,
+  fb_sprite_draw_char,
+  fb_sprite_push,
+  fb_set_text_color
+};
+
+uint16_t *tb_display_framebuffer_pixels(){
+  return fb_pixels;
+}
+
+int tb_display_framebuffer_width(){
+  return fb_width;
+}
+
+int tb_display_framebuffer_height(){
+  return fb_height;
+}
+
+void tb_display_framebuffer_set_text_color(uint16_t color){
+  fb_text_color = color;
+  fb_text_bgcolor = color;
+}
+
+int tb_display_framebuffer_scroll_offset(){
+  return fb_scroll_offset;
+}
+
+// =============================================================
+// write the actual frame as binary PPM (P6) image file
+// The frame is written as shown on the screen (with scroll offset)
+// returns false if the file could not be written
+// =============================================================
+bool tb_display_framebuffer_write_ppm(const char *filename){
+  if(fb_pixels == NULL)
+    return false;
+  FILE *f = fopen(filename, "wb");
+  if(f == NULL)
+    return false;
+  fprintf(f, "P6\n%d %d\n255\n", fb_width, fb_height);
+  for(int y = 0; y < fb_height; y++){
+    const uint16_t *line = fb_pixels + ((y + fb_scroll_offset) % fb_height)*fb_width;
+    for(int x = 0; x < fb_width; x++){
+      uint16_t color = line[x];
+      // RGB565 to RGB888
+      uint8_t rgb[3];
+      rgb[0] = ((color >> 11) & 0x1F) * 255 / 31;
+      rgb[1] = ((color >> 5) & 0x3F) * 255 / 63;
+      rgb[2] = (color & 0x1F) * 255 / 31;
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  bool ok = (ferror(f) == 0);
+  fclose(f);
+  return ok;
+}
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * tb_display_glyph_cache.cpp
+ * Cache of pre-rendered characters for the display backends.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdlib.h>
+#include "tb_display_config.h"
+#include "tb_display_glyph_cache.h"
+
+// the characters 32 - 127 of one color variant
+typedef struct {
+  uint16_t color;
+  uint16_t bgcolor;
+  // the variant holds characters
+  bool used;
+  // value of the use counter at the last use
+  uint32_t last_use;
+  // memory of the characters of this variant
+  uint32_t bytes;
+  // the pixels of each character (NULL = not rendered yet)
+  uint16_t *glyph[96];
+} glyph_variant;
+
+static glyph_variant glyph_variants[TB_DISPLAY_GLYPH_VARIANTS];
+// the variant of the last character (most characters have the same colors)
+static int glyph_last_variant = -1;
+// counted up with every use of a variant
+static uint32_t glyph_use_count = 0;
+// statistics
+static uint32_t glyph_cache_bytes = 0;
+static uint32_t glyph_cache_hits = 0;
+static uint32_t glyph_cache_misses = 0;
+static uint32_t glyph_cache_evictions = 0;
+
+// =============================================================
+// remove all characters of a variant
+// =============================================================
+static void tb_display_glyph_variant_free(int variant){
+  glyph_variant *v = &glyph_variants[variant];
+  for(int n=0; n<96; n++){
+    free(v->glyph[n]);
+    v->glyph[n] = NULL;
+  }
+  glyph_cache_bytes -= v->bytes;
+  v->bytes = 0;
+  v->used = false;
+  if(glyph_last_variant == variant)
+    glyph_last_variant = -1;
+}
+
+// =============================================================
+// the variant that was not used for the longest time
+// except the variant "keep"
+// returns -1 if there is no other variant
+// =============================================================
+static int tb_display_glyph_variant_lru(int keep){
+  int oldest = -1;
+  for(int n=0; n<TB_DISPLAY_GLYPH_VARIANTS; n++){
+    if(n == keep || !glyph_variants[n].used)
+      continue;
+    if(oldest < 0 || glyph_use_count - glyph_variants[n].last_use > glyph_use_count - glyph_variants[oldest].last_use)
+      oldest = n;
+  }
+  return oldest;
+}
+
+// =============================================================
+// the variant of the colors
+// A new variant replaces the variant that was not used for
+// the longest time, if all variants are used.
+// =============================================================
+static int tb_display_glyph_variant(uint16_t color, uint16_t bgcolor){
+  if(glyph_last_variant >= 0 && glyph_variants[glyph_last_variant].color == color &&
+     glyph_variants[glyph_last_variant].bgcolor == bgcolor)
+    return glyph_last_variant;
+  int variant = -1;
+  for(int n=0; n<TB_DISPLAY_GLYPH_VARIANTS; n++){
+    if(glyph_variants[n].used && glyph_variants[n].color == color && glyph_variants[n].bgcolor == bgcolor)
+      return glyph_last_variant = n;
+    if(variant < 0 && !glyph_variants[n].used)
+      variant = n;
+  }
+  if(variant < 0){
+    variant = tb_display_glyph_variant_lru(-1);
+    tb_display_glyph_variant_free(variant);
+    glyph_cache_evictions++;
+  }
+  glyph_variants[variant].color = color;
+  glyph_variants[variant].bgcolor = bgcolor;
+  glyph_variants[variant].used = true;
+  return glyph_last_variant = variant;
+}
+
+// =============================================================
+// returns the pixels of the character c with the colors
+// =============================================================
+const uint16_t *tb_display_glyph_cache_get(uint16_t c, int width, uint16_t color,
+                                           uint16_t bgcolor, tb_display_glyph_render render){
+  if(c < 32 || c > 127 || width <= 0)
+    return NULL;
+  uint32_t size = width*TEXT_HEIGHT*sizeof(uint16_t);
+  if(size > TB_DISPLAY_GLYPH_CACHE_BYTES)
+    return NULL;
+  int variant = tb_display_glyph_variant(color, bgcolor);
+  glyph_variant *v = &glyph_variants[variant];
+  v->last_use = ++glyph_use_count;
+  if(v->glyph[c-32] != NULL){
+    glyph_cache_hits++;
+    return v->glyph[c-32];
+  }
+  // make room: remove the variants that were not used for the longest time
+  while(glyph_cache_bytes + size > TB_DISPLAY_GLYPH_CACHE_BYTES){
+    int oldest = tb_display_glyph_variant_lru(variant);
+    if(oldest < 0)
+      return NULL;
+    tb_display_glyph_variant_free(oldest);
+    glyph_cache_evictions++;
+  }
+  uint16_t *pixels = (uint16_t*)malloc(size);
+  if(pixels == NULL)
+    return NULL;
+  render(pixels, c, width, color, bgcolor);
+  v->glyph[c-32] = pixels;
+  v->bytes += size;
+  glyph_cache_bytes += size;
+  glyph_cache_misses++;
+  return pixels;
+}
+
+// =============================================================
+// remove all characters from the cache
+// =============================================================
+void tb_display_glyph_cache_clear(){
+  for(int n=0; n<TB_DISPLAY_GLYPH_VARIANTS; n++)
+    tb_display_glyph_variant_free(n);
+}
+
+// =============================================================
+// statistics of the cache
+// =============================================================
+uint32_t tb_display_glyph_cache_bytes(){
+  return glyph_cache_bytes;
+}
+
+uint32_t tb_display_glyph_cache_hits(){
+  return glyph_cache_hits;
+}
+
+uint32_t tb_display_glyph_cache_misses(){
+  return glyph_cache_misses;
+}
+
+uint32_t tb_display_glyph_cache_evictions(){
+  return glyph_cache_evictions;
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * tb_display_glyph_cache.h
+ * Cache of pre-rendered characters for the display backends.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Drawing a character with the font of the M5Stick reads the font data
+ * and scales it pixel by pixel for every character. The cache keeps
+ * the finished RGB565 pixels of a character for each text and
+ * background color, so a character that was drawn before is copied
+ * to the screen with one pushImage.
+ * The pixels of a character are rendered by the backend the first
+ * time the character is needed with these colors. All characters with
+ * the same colors form a color variant.
+ * The memory of the cache is limited with TB_DISPLAY_GLYPH_CACHE_BYTES
+ * (tb_display_config.h). If it is full, the color variant that was
+ * not used for the longest time is removed. At most
+ * TB_DISPLAY_GLYPH_VARIANTS color variants are kept.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_GLYPH_CACHE_H
+#define TB_DISPLAY_GLYPH_CACHE_H
+
+#include <stdint.h>
+
+// =============================================================
+// render the character c with the colors into "pixels"
+// (width x TEXT_HEIGHT pixel, one row after the other)
+// provided by the backend
+// =============================================================
+typedef void (*tb_display_glyph_render)(uint16_t *pixels, uint16_t c, int width,
+                                        uint16_t color, uint16_t bgcolor);
+
+// =============================================================
+//           tb_display_glyph_cache_get(c, width, color, bgcolor, render);
+// returns the pixels of the character c (32 - 127) with the colors
+// The character is rendered with "render" if it is not in the cache.
+// returns NULL if the character can not be cached (the backend
+// draws it as before)
+// =============================================================
+const uint16_t *tb_display_glyph_cache_get(uint16_t c, int width, uint16_t color,
+                                           uint16_t bgcolor, tb_display_glyph_render render);
+
+// =============================================================
+//           tb_display_glyph_cache_clear();
+// remove all characters from the cache and free the memory
+// =============================================================
+void tb_display_glyph_cache_clear();
+
+// =============================================================
+// statistics of the cache
+// bytes     = memory used by the cached characters
+// hits      = characters copied from the cache
+// misses    = characters rendered into the cache
+// evictions = color variants removed from the cache
+// =============================================================
+uint32_t tb_display_glyph_cache_bytes();
+uint32_t tb_display_glyph_cache_hits();
+uint32_t tb_display_glyph_cache_misses();
+uint32_t tb_display_glyph_cache_evictions();
+
+#endif // TB_DISPLAY_GLYPH_CACHE_H
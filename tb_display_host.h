@@ -0,0 +1,116 @@
+/******************************************************************************
+ * tb_display_host.h
+ * Minimal replacement of the Arduino framework for host builds.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Only used with the build flag TB_DISPLAY_HOST.
+ * It provides the few Arduino types and functions the library needs,
+ * so the text buffer and the framebuffer backend can be compiled and
+ * profiled on a Linux host:
+ *    g++ -D TB_DISPLAY_HOST -I. tb_display*.cpp my_host_main.cpp
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_HOST_H
+#define TB_DISPLAY_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// the colors used by the library
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+// time since the first call, like on the device since boot
+inline unsigned long micros(){
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis(){
+  return micros() / 1000;
+}
+
+inline void delay(unsigned long ms){
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// the number formats of print()
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// the formatted output of Arduino (see tb_display_print.h)
+// Like on the device, a number is converted in a small buffer
+// and written at once, a '-' sign and println() are separate writes.
+class Print {
+public:
+  virtual ~Print(){}
+  virtual size_t write(uint8_t data) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size){
+    size_t n = 0;
+    while(size--)
+      n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char *s){ return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char *s){ return write(s); }
+  size_t print(char c){ return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC){ return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC){ return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC){ return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC){
+    if(base == DEC && n < 0)
+      return print('-') + print_number(0UL - (unsigned long)n, base);
+    return print_number((unsigned long)n, base);
+  }
+  size_t print(unsigned long n, int base = DEC){ return print_number(n, base); }
+  size_t print(double n, int digits = 2){
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+    return write((const uint8_t*)buffer, length);
+  }
+  size_t println(){ return write((const uint8_t*)"\r\n", 2); }
+  template<typename T> size_t println(const T &value){ size_t n = print(value); return n + println(); }
+  template<typename T> size_t println(const T &value, int format){ size_t n = print(value, format); return n + println(); }
+private:
+  size_t print_number(unsigned long n, int base){
+    char buffer[8*sizeof(long)+1];
+    char *s = &buffer[sizeof(buffer)];
+    if(base < 2)
+      base = 10;
+    do {
+      int digit = n % base;
+      *--s = digit < 10 ? '0' + digit : 'A' + digit - 10;
+      n /= base;
+    } while(n > 0);
+    return write((const uint8_t*)s, &buffer[sizeof(buffer)] - s);
+  }
+};
+
+// the serial input of Arduino (see tb_serial_replay.cpp)
+// readBytes() does not wait, it reads only the available bytes
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(uint8_t *buffer, size_t length){
+    size_t n = 0;
+    while(n < length && available() > 0)
+      buffer[n++] = read();
+    return n;
+  }
+};
+
+#endif // TB_DISPLAY_HOST_H
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * tb_display_keyboard.cpp
+ * Polling of the Keyboard-Hat (CardKB) for the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+  #include <Wire.h>
+#endif
+#include "tb_display_config.h"
+#include "tb_display_keyboard.h"
+
+static tb_display_keyboard_reader keyboard_reader = NULL;
+// the keys (a ring)
+static uint8_t keyboard_queue[TB_DISPLAY_KEYBOARD_QUEUE];
+static int keyboard_first = 0;
+static int keyboard_count = 0;
+// time of the last read and of the last key
+static unsigned long keyboard_last_poll = 0;
+static unsigned long keyboard_last_key = 0;
+static unsigned long keyboard_interval = TB_DISPLAY_KEYBOARD_FAST_MS;
+// statistics
+static uint32_t keyboard_transactions = 0;
+static uint32_t keyboard_dropped = 0;
+
+#ifndef TB_DISPLAY_HOST
+// =============================================================
+// read one key from the Keyboard-Hat
+// =============================================================
+uint8_t tb_display_keyboard_cardkb(){
+  uint8_t key = 0;
+  Wire.requestFrom(TB_DISPLAY_CARDKB_ADDR, 1);
+  while(Wire.available())
+    key = Wire.read();
+  return key;
+}
+#endif
+
+// =============================================================
+// start the polling of the keyboard
+// =============================================================
+void tb_display_keyboard_begin(tb_display_keyboard_reader reader){
+  keyboard_reader = reader;
+  keyboard_first = 0;
+  keyboard_count = 0;
+  keyboard_interval = TB_DISPLAY_KEYBOARD_FAST_MS;
+  keyboard_last_poll = millis();
+  keyboard_last_key = keyboard_last_poll;
+}
+
+// =============================================================
+// read the keyboard if the poll interval is over
+// The interval is short while keys are typed and grows
+// step by step when no key was typed for a while.
+// =============================================================
+bool tb_display_keyboard_poll(){
+  if(keyboard_reader == NULL)
+    return false;
+  unsigned long now = millis();
+  if(now - keyboard_last_poll < keyboard_interval)
+    return false;
+  keyboard_last_poll = now;
+  keyboard_transactions++;
+  uint8_t key = keyboard_reader();
+  if(key != 0){
+    if(keyboard_count < TB_DISPLAY_KEYBOARD_QUEUE){
+      keyboard_queue[(keyboard_first + keyboard_count) % TB_DISPLAY_KEYBOARD_QUEUE] = key;
+      keyboard_count++;
+    } else {
+      keyboard_dropped++;
+    }
+    keyboard_last_key = now;
+    keyboard_interval = TB_DISPLAY_KEYBOARD_FAST_MS;
+  } else if(now - keyboard_last_key >= TB_DISPLAY_KEYBOARD_ACTIVE_MS &&
+            keyboard_interval < TB_DISPLAY_KEYBOARD_SLOW_MS){
+    // nobody is typing: read the keyboard less often
+    keyboard_interval *= 2;
+    if(keyboard_interval > TB_DISPLAY_KEYBOARD_SLOW_MS)
+      keyboard_interval = TB_DISPLAY_KEYBOARD_SLOW_MS;
+  }
+  return true;
+}
+
+// =============================================================
+// returns the next key of the queue or -1
+// =============================================================
+int tb_display_keyboard_read(){
+  if(keyboard_count == 0)
+    return -1;
+  uint8_t key = keyboard_queue[keyboard_first];
+  keyboard_first = (keyboard_first + 1) % TB_DISPLAY_KEYBOARD_QUEUE;
+  keyboard_count--;
+  return key;
+}
+
+// =============================================================
+// state and statistics of the polling
+// =============================================================
+int tb_display_keyboard_available(){
+  return keyboard_count;
+}
+
+unsigned long tb_display_keyboard_interval(){
+  return keyboard_interval;
+}
+
+uint32_t tb_display_keyboard_transactions(){
+  return keyboard_transactions;
+}
+
+uint32_t tb_display_keyboard_dropped(){
+  return keyboard_dropped;
+}
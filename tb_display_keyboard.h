@@ -0,0 +1,84 @@
+/******************************************************************************
+ * tb_display_keyboard.h
+ * Polling of the Keyboard-Hat (CardKB) for the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Each read of the Keyboard-Hat is an I2C transaction that blocks the
+ * loop() for a while. Reading it in every loop() pass limits the loop
+ * rate, even if nobody is typing.
+ * tb_display_keyboard_poll() is called in the loop() and reads the
+ * keyboard only when the poll interval is over. While keys are typed,
+ * the keyboard is read every TB_DISPLAY_KEYBOARD_FAST_MS milliseconds.
+ * Without keys for TB_DISPLAY_KEYBOARD_ACTIVE_MS milliseconds, the
+ * interval grows step by step up to TB_DISPLAY_KEYBOARD_SLOW_MS.
+ * The keys are kept in a small queue until they are read with
+ * tb_display_keyboard_read(). The times and the size of the queue are
+ * set in tb_display_config.h.
+ *
+ * The keyboard is read through a function, so another keyboard or a
+ * scripted replacement (e.g. on a Linux host) can be used.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_KEYBOARD_H
+#define TB_DISPLAY_KEYBOARD_H
+
+#include <stdint.h>
+
+// =============================================================
+// read one key from the keyboard (one bus transaction)
+// returns the key or 0 if no key was pressed
+// =============================================================
+typedef uint8_t (*tb_display_keyboard_reader)();
+
+#ifndef TB_DISPLAY_HOST
+// =============================================================
+// reads the Keyboard-Hat at the I2C address TB_DISPLAY_CARDKB_ADDR
+// (Wire.begin() must be called before)
+// =============================================================
+uint8_t tb_display_keyboard_cardkb();
+#endif
+
+// =============================================================
+//           tb_display_keyboard_begin(reader);
+// start the polling of the keyboard
+// example:
+//    Wire.begin(0, 26);
+//    tb_display_keyboard_begin(tb_display_keyboard_cardkb);
+// =============================================================
+void tb_display_keyboard_begin(tb_display_keyboard_reader reader);
+
+// =============================================================
+//           tb_display_keyboard_poll();
+// read the keyboard if the poll interval is over
+// call it as often as possible in the loop()
+// returns true if the keyboard was read
+// =============================================================
+bool tb_display_keyboard_poll();
+
+// =============================================================
+//           tb_display_keyboard_read();
+// returns the next key of the queue or -1 if there is no key
+// example:
+//    tb_display_keyboard_poll();
+//    int key;
+//    while((key = tb_display_keyboard_read()) >= 0)
+//      tb_display_queue_push(key);
+// =============================================================
+int tb_display_keyboard_read();
+
+// =============================================================
+//           tb_display_keyboard_...
+// state and statistics of the polling
+// available    = number of keys in the queue
+// interval     = actual poll interval in milliseconds
+// transactions = number of keyboard reads (bus transactions)
+// dropped      = keys dropped because the queue was full
+// =============================================================
+int tb_display_keyboard_available();
+unsigned long tb_display_keyboard_interval();
+uint32_t tb_display_keyboard_transactions();
+uint32_t tb_display_keyboard_dropped();
+
+#endif // TB_DISPLAY_KEYBOARD_H
@@ -0,0 +1,440 @@
+/******************************************************************************
+ * tb_display_mirror.cpp
+ * Mirror of the text buffer display over a serial port.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "tb_display_config.h"
+#include "tb_display_viewport.h"
+#include "tb_display_mirror.h"
+
+#if TB_DISPLAY_MIRROR_FRAME_BYTES < 3*TEXT_BUFFER_LINE_LENGTH_WIDE + 16 || \
+    TB_DISPLAY_MIRROR_FRAME_BYTES > TB_DISPLAY_MIRROR_MAX_FRAME
+  #error "TB_DISPLAY_MIRROR_FRAME_BYTES does not fit to the rows or the decoder"
+#endif
+
+// the start of a frame
+#define MIRROR_SYNC_1 0xA5
+#define MIRROR_SYNC_2 0x5A
+// start, sequence number, type and length
+#define MIRROR_HEADER 6
+// rows, line length and the positions
+#define MIRROR_POSITIONS 5
+// the characters of a row
+#define MIRROR_END     0x00 // the row ends here
+#define MIRROR_REPEAT  0x01 // n times the next character
+#define MIRROR_ATTR    0x02 // the colors of the next characters
+#define MIRROR_CHANGES 0x03 // the rest of the row is unchanged
+// a repeated character is sent with MIRROR_REPEAT from this count
+#define MIRROR_MIN_REPEAT 4
+
+static tb_display_mirror_writer mirror_writer = NULL;
+// copy of the text buffer as it was sent
+static char *mirror_text = NULL;
+static uint8_t *mirror_attr = NULL;
+static int mirror_rows = 0;
+static int mirror_line_length = 0;
+static int mirror_read_pointer_y = 0;
+static int mirror_write_pointer_y = 0;
+static int mirror_write_pointer_x = 0;
+// the next update sends a key frame
+static bool mirror_key = true;
+static unsigned long mirror_key_time = 0;
+// the frame that is filled
+static uint8_t mirror_frame[TB_DISPLAY_MIRROR_FRAME_BYTES];
+static int mirror_frame_length = 0;
+static uint8_t mirror_seq = 0;
+// statistics
+static uint32_t mirror_bytes = 0;
+static uint32_t mirror_frames = 0;
+
+// =============================================================
+// CRC-8 with the polynomial 0x07
+// =============================================================
+static uint8_t tb_display_mirror_crc(const uint8_t *data, size_t length){
+  uint8_t crc = 0;
+  for(size_t n = 0; n < length; n++){
+    crc ^= data[n];
+    for(int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+// =============================================================
+// length of a row of the text buffer (without the null terminator)
+// =============================================================
+static int tb_display_mirror_length(const char *text, int line_length){
+  int length = 0;
+  while(length < line_length && text[length] != '\0')
+    length++;
+  return length;
+}
+
+// =============================================================
+// start a new frame with the positions of the text buffer
+// =============================================================
+static void tb_display_mirror_frame_start(tb_display_viewport *vp, char type){
+  mirror_frame[0] = MIRROR_SYNC_1;
+  mirror_frame[1] = MIRROR_SYNC_2;
+  mirror_frame[2] = mirror_seq;
+  mirror_frame[3] = type;
+  mirror_frame[6] = vp->rows;
+  mirror_frame[7] = vp->line_length;
+  mirror_frame[8] = vp->read_pointer_y;
+  mirror_frame[9] = vp->write_pointer_y;
+  mirror_frame[10] = vp->write_pointer_x;
+  mirror_frame_length = MIRROR_HEADER + MIRROR_POSITIONS;
+}
+
+// =============================================================
+// send the frame
+// returns the number of bytes sent
+// =============================================================
+static size_t tb_display_mirror_frame_send(){
+  int payload = mirror_frame_length - MIRROR_HEADER;
+  mirror_frame[4] = payload & 0xFF;
+  mirror_frame[5] = payload >> 8;
+  mirror_frame[mirror_frame_length] = tb_display_mirror_crc(mirror_frame+2, mirror_frame_length-2);
+  size_t length = mirror_frame_length + 1;
+  mirror_writer(mirror_frame, length);
+  mirror_seq++;
+  mirror_bytes += length;
+  mirror_frames++;
+  return length;
+}
+
+// =============================================================
+// add the characters "start" to "end" of a row to the frame
+// "last" = MIRROR_END if the row ends behind the characters,
+// MIRROR_CHANGES if the rest of the row is unchanged
+// A full frame is sent and the row continues in the next frame.
+// returns the number of bytes sent
+// =============================================================
+static size_t tb_display_mirror_row(tb_display_viewport *vp, int row, int start, int end, uint8_t last){
+  const char *text = vp->text + row*vp->line_length;
+  const uint8_t *attr = vp->attr + row*vp->line_length;
+  size_t sent = 0;
+  // row number, position, colors, character and the end
+  // are at most 3 bytes per character + 3 bytes + the CRC
+  if(mirror_frame_length + 3*(end-start) + 4 > TB_DISPLAY_MIRROR_FRAME_BYTES){
+    sent += tb_display_mirror_frame_send();
+    tb_display_mirror_frame_start(vp, 'D');
+  }
+  mirror_frame[mirror_frame_length++] = row;
+  mirror_frame[mirror_frame_length++] = start;
+  uint8_t color = TB_ATTR_DEFAULT;
+  int pos = start;
+  while(pos < end){
+    if(attr[pos] != color){
+      color = attr[pos];
+      mirror_frame[mirror_frame_length++] = MIRROR_ATTR;
+      mirror_frame[mirror_frame_length++] = color;
+    }
+    // the same character with the same colors
+    int count = 1;
+    while(pos+count < end && count < 255 && text[pos+count] == text[pos] && attr[pos+count] == color)
+      count++;
+    if(count >= MIRROR_MIN_REPEAT){
+      mirror_frame[mirror_frame_length++] = MIRROR_REPEAT;
+      mirror_frame[mirror_frame_length++] = count;
+      mirror_frame[mirror_frame_length++] = text[pos];
+      pos += count;
+    } else {
+      mirror_frame[mirror_frame_length++] = text[pos++];
+    }
+  }
+  mirror_frame[mirror_frame_length++] = last;
+  // the copy is what the host has now
+  memcpy(mirror_text + row*vp->line_length + start, text + start, end - start);
+  memcpy(mirror_attr + row*vp->line_length + start, attr + start, end - start);
+  if(last == MIRROR_END)
+    mirror_text[row*vp->line_length + end] = '\0';
+  return sent;
+}
+
+// =============================================================
+// start the mirror
+// =============================================================
+bool tb_display_mirror_begin(tb_display_mirror_writer writer){
+  tb_display_mirror_end();
+  mirror_writer = writer;
+  mirror_key = true;
+  return writer != NULL;
+}
+
+// =============================================================
+// stop the mirror and free the memory
+// =============================================================
+void tb_display_mirror_end(){
+  free(mirror_text);
+  free(mirror_attr);
+  mirror_text = NULL;
+  mirror_attr = NULL;
+  mirror_rows = 0;
+  mirror_line_length = 0;
+  mirror_writer = NULL;
+}
+
+// =============================================================
+// the next update sends all rows
+// =============================================================
+void tb_display_mirror_key_frame(){
+  mirror_key = true;
+}
+
+// =============================================================
+// send the changes of the text buffer
+// =============================================================
+size_t tb_display_mirror_update(){
+  if(mirror_writer == NULL)
+    return 0;
+  tb_display_viewport *vp = tb_display_screen_viewport();
+  // a new size of the text buffer (tb_display_init or a rotation)
+  if(vp->rows != mirror_rows || vp->line_length != mirror_line_length){
+    free(mirror_text);
+    free(mirror_attr);
+    mirror_text = (char*)malloc(vp->rows*vp->line_length);
+    mirror_attr = (uint8_t*)malloc(vp->rows*vp->line_length);
+    if(mirror_text == NULL || mirror_attr == NULL){
+      tb_display_mirror_end();
+      return 0;
+    }
+    mirror_rows = vp->rows;
+    mirror_line_length = vp->line_length;
+    mirror_key = true;
+  }
+#if TB_DISPLAY_MIRROR_KEY_MS > 0
+  if(millis() - mirror_key_time >= TB_DISPLAY_MIRROR_KEY_MS)
+    mirror_key = true;
+#endif
+  size_t sent = 0;
+  if(mirror_key){
+    // all rows that are not empty
+    mirror_key = false;
+    mirror_key_time = millis();
+    tb_display_mirror_frame_start(vp, 'K');
+    for(int row = 0; row < vp->rows; row++){
+      int length = tb_display_mirror_length(vp->text + row*vp->line_length, vp->line_length);
+      mirror_text[row*vp->line_length] = '\0';
+      if(length > 0)
+        sent += tb_display_mirror_row(vp, row, 0, length, MIRROR_END);
+    }
+  } else {
+    tb_display_mirror_frame_start(vp, 'D');
+    for(int row = 0; row < vp->rows; row++){
+      const char *text = vp->text + row*vp->line_length;
+      const uint8_t *attr = vp->attr + row*vp->line_length;
+      const char *old_text = mirror_text + row*vp->line_length;
+      const uint8_t *old_attr = mirror_attr + row*vp->line_length;
+      int length = tb_display_mirror_length(text, vp->line_length);
+      int old_length = tb_display_mirror_length(old_text, vp->line_length);
+      int common = length < old_length ? length : old_length;
+      // the first changed character
+      int first = 0;
+      while(first < common && text[first] == old_text[first] && attr[first] == old_attr[first])
+        first++;
+      if(first == common && length == old_length)
+        continue;
+      if(length != old_length){
+        sent += tb_display_mirror_row(vp, row, first, length, MIRROR_END);
+      } else {
+        // the same length: only up to the last changed character
+        int last = length - 1;
+        while(text[last] == old_text[last] && attr[last] == old_attr[last])
+          last--;
+        sent += tb_display_mirror_row(vp, row, first, last+1, MIRROR_CHANGES);
+      }
+    }
+    // nothing has changed
+    if(mirror_frame_length == MIRROR_HEADER + MIRROR_POSITIONS &&
+       vp->read_pointer_y == mirror_read_pointer_y &&
+       vp->write_pointer_y == mirror_write_pointer_y &&
+       vp->write_pointer_x == mirror_write_pointer_x)
+      return sent;
+  }
+  mirror_read_pointer_y = vp->read_pointer_y;
+  mirror_write_pointer_y = vp->write_pointer_y;
+  mirror_write_pointer_x = vp->write_pointer_x;
+  sent += tb_display_mirror_frame_send();
+  return sent;
+}
+
+uint32_t tb_display_mirror_bytes(){
+  return mirror_bytes;
+}
+
+uint32_t tb_display_mirror_frames(){
+  return mirror_frames;
+}
+
+// =============================================================
+// the decoder
+// =============================================================
+void tb_display_mirror_decoder_init(tb_display_mirror_decoder *decoder){
+  memset(decoder, 0, sizeof(tb_display_mirror_decoder));
+}
+
+// =============================================================
+// apply the payload of a frame to the rows
+// returns false if the payload does not fit to the rows
+// =============================================================
+static bool tb_display_mirror_apply(tb_display_mirror_decoder *decoder, const uint8_t *data, int length){
+  if(length < MIRROR_POSITIONS)
+    return false;
+  int rows = data[0];
+  int line_length = data[1];
+  if(rows > TB_DISPLAY_MIRROR_MAX_ROWS || line_length > TB_DISPLAY_MIRROR_MAX_COLUMNS)
+    return false;
+  if(rows != decoder->rows || line_length != decoder->line_length)
+    return false;
+  decoder->read_pointer_y = data[2];
+  decoder->write_pointer_y = data[3];
+  decoder->write_pointer_x = data[4];
+  int n = MIRROR_POSITIONS;
+  while(n + 2 <= length){
+    int row = data[n++];
+    int pos = data[n++];
+    if(row >= rows)
+      return false;
+    char *text = decoder->text[row];
+    uint8_t *attr = decoder->attr[row];
+    uint8_t color = TB_ATTR_DEFAULT;
+    bool row_done = false;
+    while(n < length && !row_done){
+      uint8_t token = data[n++];
+      if(token == MIRROR_END){
+        if(pos >= line_length)
+          return false;
+        text[pos] = '\0';
+        row_done = true;
+      } else if(token == MIRROR_CHANGES){
+        row_done = true;
+      } else if(token == MIRROR_ATTR){
+        if(n >= length)
+          return false;
+        color = data[n++];
+      } else {
+        int count = 1;
+        if(token == MIRROR_REPEAT){
+          if(n + 2 > length)
+            return false;
+          count = data[n++];
+          token = data[n++];
+        }
+        // the last character of a row is the null terminator
+        if(pos + count >= line_length)
+          return false;
+        for(int c = 0; c < count; c++){
+          text[pos] = token;
+          attr[pos++] = color;
+        }
+      }
+    }
+    if(!row_done)
+      return false;
+  }
+  return n == length;
+}
+
+// =============================================================
+// a complete frame with a correct CRC was received
+// =============================================================
+static bool tb_display_mirror_frame(tb_display_mirror_decoder *decoder){
+  const uint8_t *frame = decoder->frame;
+  int payload = frame[4] | (frame[5] << 8);
+  uint8_t seq = frame[2];
+  if(frame[3] == 'K' && payload >= MIRROR_POSITIONS &&
+     frame[MIRROR_HEADER] <= TB_DISPLAY_MIRROR_MAX_ROWS &&
+     frame[MIRROR_HEADER+1] <= TB_DISPLAY_MIRROR_MAX_COLUMNS){
+    // a key frame: all rows are sent again
+    memset(decoder->text, 0, sizeof(decoder->text));
+    memset(decoder->attr, TB_ATTR_DEFAULT, sizeof(decoder->attr));
+    decoder->rows = frame[MIRROR_HEADER];
+    decoder->line_length = frame[MIRROR_HEADER+1];
+    decoder->synced = true;
+  } else if(!decoder->synced || seq != (uint8_t)(decoder->seq + 1)){
+    // a frame is missing: wait for the next key frame
+    if(decoder->synced)
+      decoder->lost++;
+    decoder->synced = false;
+    return false;
+  }
+  decoder->seq = seq;
+  if(!tb_display_mirror_apply(decoder, frame+MIRROR_HEADER, payload)){
+    decoder->errors++;
+    decoder->synced = false;
+    return false;
+  }
+  decoder->frames++;
+  return true;
+}
+
+// =============================================================
+// the received bytes are not a frame: search the next start
+// of a frame in the received bytes
+// =============================================================
+static void tb_display_mirror_resync(tb_display_mirror_decoder *decoder){
+  uint32_t start = 1;
+  while(start < decoder->frame_length && decoder->frame[start] != MIRROR_SYNC_1)
+    start++;
+  decoder->frame_length -= start;
+  memmove(decoder->frame, decoder->frame + start, decoder->frame_length);
+}
+
+// =============================================================
+// put a received byte into the decoder
+// =============================================================
+bool tb_display_mirror_decode(tb_display_mirror_decoder *decoder, uint8_t data){
+  // the start of a frame
+  if(decoder->frame_length == 0 && data != MIRROR_SYNC_1)
+    return false;
+  decoder->frame[decoder->frame_length++] = data;
+  // after a wrong frame, the next frames can be in the received bytes
+  bool applied = false;
+  while(decoder->frame_length > 0){
+    const uint8_t *frame = decoder->frame;
+    if(decoder->frame_length >= 2 && frame[1] != MIRROR_SYNC_2){
+      tb_display_mirror_resync(decoder);
+      continue;
+    }
+    if(decoder->frame_length < MIRROR_HEADER)
+      break;
+    uint32_t length = MIRROR_HEADER + (frame[4] | (frame[5] << 8)) + 1;
+    if(length > TB_DISPLAY_MIRROR_MAX_FRAME){
+      decoder->errors++;
+      tb_display_mirror_resync(decoder);
+      continue;
+    }
+    if(decoder->frame_length < length)
+      break;
+    if(tb_display_mirror_crc(frame+2, length-3) != frame[length-1]){
+      decoder->errors++;
+      tb_display_mirror_resync(decoder);
+      continue;
+    }
+    if(tb_display_mirror_frame(decoder))
+      applied = true;
+    decoder->frame_length -= length;
+    memmove(decoder->frame, decoder->frame + length, decoder->frame_length);
+  }
+  return applied;
+}
+
+// =============================================================
+// the text of the row n of the screen (0 = top row)
+// =============================================================
+const char *tb_display_mirror_row(const tb_display_mirror_decoder *decoder, int n){
+  if(decoder->rows == 0)
+    return "";
+  return decoder->text[(decoder->read_pointer_y + n) % decoder->rows];
+}
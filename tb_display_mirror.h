@@ -0,0 +1,151 @@
+/******************************************************************************
+ * tb_display_mirror.h
+ * Mirror of the text buffer display over a serial port.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The mirror sends the text of the display to a host, e.g. if the
+ * M5Stick is mounted somewhere hard to see. Only the changes are sent:
+ * tb_display_mirror_update() compares the rows of the text buffer with
+ * a copy of what was sent before and sends the changed part of each
+ * changed row and the read and write positions in one frame. A new
+ * line only moves the read position and clears one row, so the bytes
+ * of an update grow with the changed characters, not with the size
+ * of the screen.
+ *
+ * Frame:
+ *   0xA5 0x5A      start of a frame
+ *   seq            sequence number (counts up, 0 after 255)
+ *   type           'K' = key frame: all rows, the host clears its rows
+ *                  'D' = delta frame: only the changed rows
+ *   length         length of the payload (2 bytes, low byte first)
+ *   payload
+ *   crc            CRC-8 (polynomial 0x07) of seq, type, length and payload
+ * Payload:
+ *   rows, line_length, read_pointer_y, write_pointer_y, write_pointer_x
+ *   the changed rows: row number, first changed character, characters
+ * Characters of a row:
+ *   0x00           end of the row (the row ends here)
+ *   0x01 n c       n times the character c
+ *   0x02 a         the colors of the following characters (at the start
+ *                  of a row: TB_ATTR_DEFAULT)
+ *   0x03           end of the changes (the rest of the row is unchanged)
+ *   32 - 255       a character
+ * Rows of the text buffer are sent in the order of the memory; row
+ * "read_pointer_y" is the top row of the screen.
+ * A frame with a wrong CRC or a missing sequence number is dropped by
+ * the decoder. It waits for the next key frame, which is sent every
+ * TB_DISPLAY_MIRROR_KEY_MS milliseconds (tb_display_config.h).
+ *
+ * The decoder of the frames (tb_display_mirror_decode) is part of this
+ * file as well. tb_mirror_view.cpp is a decoder for a Linux host.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_MIRROR_H
+#define TB_DISPLAY_MIRROR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================
+// write the bytes of a frame (e.g. with Serial.write)
+// returns the number of written bytes
+// =============================================================
+typedef size_t (*tb_display_mirror_writer)(const uint8_t *data, size_t length);
+
+// =============================================================
+//           tb_display_mirror_begin(writer);
+// start the mirror, the first update sends a key frame
+// returns false if there is not enough memory for the copy
+// of the text buffer
+// example:
+//    size_t mirror_write(const uint8_t *data, size_t length){
+//      return Serial.write(data, length);
+//    }
+//    tb_display_mirror_begin(mirror_write);
+// =============================================================
+bool tb_display_mirror_begin(tb_display_mirror_writer writer);
+
+// =============================================================
+//           tb_display_mirror_end();
+// stop the mirror and free the memory
+// =============================================================
+void tb_display_mirror_end();
+
+// =============================================================
+//           tb_display_mirror_update();
+// send the changes of the text buffer since the last update
+// Call it in the loop(), e.g. every 100ms. With the render task, call
+// it between tb_display_lock() and tb_display_unlock().
+// returns the number of bytes sent (0 = nothing changed)
+// =============================================================
+size_t tb_display_mirror_update();
+
+// =============================================================
+//           tb_display_mirror_key_frame();
+// the next update sends all rows
+// =============================================================
+void tb_display_mirror_key_frame();
+
+// =============================================================
+// statistics of the mirror: sent bytes and frames
+// =============================================================
+uint32_t tb_display_mirror_bytes();
+uint32_t tb_display_mirror_frames();
+
+// =============================================================
+// the decoder of the frames (on the host)
+// =============================================================
+#define TB_DISPLAY_MIRROR_MAX_ROWS 32
+#define TB_DISPLAY_MIRROR_MAX_COLUMNS 128
+// maximum size of a frame (with start, header and CRC)
+#define TB_DISPLAY_MIRROR_MAX_FRAME 1024
+
+typedef struct {
+  // the text buffer of the M5Stick
+  // (rows == 0: no key frame received yet)
+  int rows;
+  int line_length;
+  int read_pointer_y;
+  int write_pointer_y;
+  int write_pointer_x;
+  char text[TB_DISPLAY_MIRROR_MAX_ROWS][TB_DISPLAY_MIRROR_MAX_COLUMNS];
+  uint8_t attr[TB_DISPLAY_MIRROR_MAX_ROWS][TB_DISPLAY_MIRROR_MAX_COLUMNS];
+  // the delta frames fit to the rows (the last frame was received)
+  bool synced;
+  uint8_t seq;
+  // statistics: applied frames, frames with a wrong CRC or a wrong
+  // content, missing frames
+  uint32_t frames;
+  uint32_t errors;
+  uint32_t lost;
+  // the frame that is received
+  uint8_t frame[TB_DISPLAY_MIRROR_MAX_FRAME];
+  uint32_t frame_length;
+} tb_display_mirror_decoder;
+
+// =============================================================
+//           tb_display_mirror_decoder_init(decoder);
+// =============================================================
+void tb_display_mirror_decoder_init(tb_display_mirror_decoder *decoder);
+
+// =============================================================
+//           tb_display_mirror_decode(decoder, data);
+// put a received byte into the decoder
+// Bytes outside of the frames are skipped.
+// returns true if a frame was applied to the rows
+// example:
+//    while(read(fd, &data, 1) == 1)
+//      if(tb_display_mirror_decode(&decoder, data))
+//        show(tb_display_mirror_row(&decoder, 0));
+// =============================================================
+bool tb_display_mirror_decode(tb_display_mirror_decoder *decoder, uint8_t data);
+
+// =============================================================
+//           tb_display_mirror_row(decoder, n);
+// the text of the row n of the screen (0 = top row)
+// =============================================================
+const char *tb_display_mirror_row(const tb_display_mirror_decoder *decoder, int n);
+
+#endif // TB_DISPLAY_MIRROR_H
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * tb_display_print.cpp
+ * Arduino Print interface of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tb_display_print.h"
+
+TB_Display TBDisplay;
+
+// =============================================================
+// formatted output like printf
+// The text is laid out at once and the screen is drawn once.
+// =============================================================
+size_t TB_Display::printf(const char *format, ...){
+  char buffer[TB_DISPLAY_PRINTF_BYTES];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if(length < 0)
+    return 0;
+  if(length < (int)sizeof(buffer))
+    return write((const uint8_t*)buffer, length);
+  // a long text: format it again in a buffer that fits
+  char *text = (char*)malloc(length+1);
+  if(text == NULL)
+    return 0;
+  va_start(args, format);
+  vsnprintf(text, length+1, format, args);
+  va_end(args);
+  size_t n = write((const uint8_t*)text, length);
+  free(text);
+  return n;
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+ * tb_display_print.h
+ * Arduino Print interface of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * TB_Display is a Print class like Serial, so numbers and texts can
+ * be printed with print(), println() and printf() without a buffer
+ * and snprintf():
+ *    TBDisplay.print("T=");
+ *    TBDisplay.print(temperature, 1);
+ *    TBDisplay.println(" C");
+ *    TBDisplay.printf("%u of %u\n", n, count);
+ * Print converts a number and calls write() once with all digits.
+ * write() lays out the characters in the text buffer directly
+ * (tb_display_print_bytes). All writes of one print(), println()
+ * or printf() are laid out first and the screen is drawn once at the
+ * end (with a limited frame rate: by the next tb_display_update()).
+ * Several prints are drawn once between tb_display_batch_begin() and
+ * tb_display_batch_end().
+ *
+ * TBDisplay prints on the screen of the tb_display functions.
+ * A TB_Display object prints on another viewport:
+ *    TB_TextBuffer<3, 20, 0, 88, 135> log_area;
+ *    TB_Display log_print(log_area.viewport());
+ *    log_print.println(millis());
+ * With the render task, print between tb_display_lock() and
+ * tb_display_unlock().
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_PRINT_H
+#define TB_DISPLAY_PRINT_H
+
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include "tb_display_viewport.h"
+
+// the text of printf() is formatted on the stack up to this size
+// (longer texts in memory from malloc)
+#define TB_DISPLAY_PRINTF_BYTES 64
+
+class TB_Display : public Print {
+public:
+  // NULL = the screen of the tb_display functions
+  TB_Display(tb_display_viewport *viewport = NULL) : vp(viewport) {}
+
+  size_t write(uint8_t data){
+    return write(&data, 1);
+  }
+  size_t write(const uint8_t *buffer, size_t size){
+    tb_display_viewport_print_bytes(viewport(), buffer, size);
+    return size;
+  }
+  using Print::write;
+
+  // all writes of a print are drawn once
+  template<typename... T> size_t print(const T&... args){
+    bool batch = begin();
+    size_t n = Print::print(args...);
+    end(batch);
+    return n;
+  }
+  template<typename... T> size_t println(const T&... args){
+    bool batch = begin();
+    size_t n = Print::println(args...);
+    end(batch);
+    return n;
+  }
+  size_t printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+  tb_display_viewport *viewport(){
+    return vp != NULL ? vp : tb_display_screen_viewport();
+  }
+
+private:
+  tb_display_viewport *vp;
+
+  // returns true if the viewport was already in a batch
+  bool begin(){
+    bool batch = viewport()->batch;
+    tb_display_viewport_batch_begin(viewport());
+    return batch;
+  }
+  void end(bool batch){
+    if(!batch)
+      tb_display_viewport_batch_end(viewport());
+  }
+};
+
+// the screen of the tb_display functions
+extern TB_Display TBDisplay;
+
+#endif // TB_DISPLAY_PRINT_H
@@ -0,0 +1,279 @@
+/******************************************************************************
+ * tb_display_queue.cpp
+ * Input queue and render task of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+  #include <mutex>
+  #include <thread>
+#else
+  #include <Arduino.h>
+#endif
+#include <atomic>
+#include "tb_display.h"
+#include "tb_display_config.h"
+#include "tb_display_queue.h"
+
+#if (TB_DISPLAY_QUEUE_SIZE & (TB_DISPLAY_QUEUE_SIZE-1)) != 0
+  #error "TB_DISPLAY_QUEUE_SIZE must be a power of 2"
+#endif
+#define QUEUE_MASK (TB_DISPLAY_QUEUE_SIZE-1)
+// characters printed with one lock of the display
+#define QUEUE_CHUNK 64
+
+// the characters of the queue
+static char queue_data[TB_DISPLAY_QUEUE_SIZE];
+// a character is ready to be taken out of the queue
+// (set by the producer after the character is written)
+static std::atomic<uint8_t> queue_ready[TB_DISPLAY_QUEUE_SIZE];
+// the positions are counted up all the time
+// the index in the arrays is position & QUEUE_MASK
+// head = position for the next character (reserved by the producers)
+// tail = position of the next character to take out (render task)
+static std::atomic<uint32_t> queue_head(0);
+static std::atomic<uint32_t> queue_tail(0);
+// statistics
+static std::atomic<uint32_t> queue_max_fill(0);
+static std::atomic<uint32_t> queue_dropped(0);
+static std::atomic<uint32_t> queue_overflows(0);
+
+// the render task
+static std::atomic<bool> render_task_stop(false);
+static std::atomic<bool> render_task_running(false);
+#ifdef TB_DISPLAY_HOST
+  static std::thread render_thread;
+  static std::mutex display_mutex;
+#else
+  static SemaphoreHandle_t display_mutex = NULL;
+#endif
+
+// =============================================================
+// add characters to the queue
+// The positions are reserved with one compare and swap, so
+// several producers can write at the same time.
+// returns the number of characters added to the queue
+// =============================================================
+static size_t tb_display_queue_write(const char *data, size_t length){
+  if(length == 0)
+    return 0;
+  uint32_t head = queue_head.load(std::memory_order_relaxed);
+  uint32_t count;
+  do {
+    // a stale head gives a wrong free space, but then the
+    // compare and swap fails and it is calculated again
+    uint32_t free_space = TB_DISPLAY_QUEUE_SIZE - (head - queue_tail.load(std::memory_order_acquire));
+    count = length < free_space ? length : free_space;
+    if(count == 0)
+      break;
+  } while(!queue_head.compare_exchange_weak(head, head+count, std::memory_order_relaxed));
+  if(count < length){
+    queue_dropped.fetch_add(length-count, std::memory_order_relaxed);
+    queue_overflows.fetch_add(1, std::memory_order_relaxed);
+  }
+  if(count == 0)
+    return 0;
+  uint32_t fill = head + count - queue_tail.load(std::memory_order_relaxed);
+  uint32_t max_fill = queue_max_fill.load(std::memory_order_relaxed);
+  while(fill > max_fill && fill <= TB_DISPLAY_QUEUE_SIZE &&
+        !queue_max_fill.compare_exchange_weak(max_fill, fill, std::memory_order_relaxed)){
+  }
+  for(uint32_t n=0; n<count; n++){
+    queue_data[(head+n) & QUEUE_MASK] = data[n];
+    queue_ready[(head+n) & QUEUE_MASK].store(1, std::memory_order_release);
+  }
+  return count;
+}
+
+// =============================================================
+// take the next character out of the queue
+// only called by one task
+// returns false if the queue is empty
+// =============================================================
+static bool tb_display_queue_pop(char *data){
+  uint32_t tail = queue_tail.load(std::memory_order_relaxed);
+  // a reserved position is not ready before the character is written
+  if(queue_ready[tail & QUEUE_MASK].load(std::memory_order_acquire) == 0)
+    return false;
+  *data = queue_data[tail & QUEUE_MASK];
+  queue_ready[tail & QUEUE_MASK].store(0, std::memory_order_relaxed);
+  // the position can be used again by the producers
+  queue_tail.store(tail+1, std::memory_order_release);
+  return true;
+}
+
+// =============================================================
+// add a character to the queue
+// =============================================================
+bool tb_display_queue_push(char data){
+  return tb_display_queue_write(&data, 1) == 1;
+}
+
+// =============================================================
+// add a string to the queue
+// =============================================================
+size_t tb_display_queue_push_String(const char *s){
+  return tb_display_queue_write(s, strlen(s));
+}
+
+// =============================================================
+// add a block of characters to the queue
+// =============================================================
+size_t tb_display_queue_push_bytes(const uint8_t *data, size_t length){
+  return tb_display_queue_write((const char*)data, length);
+}
+
+// =============================================================
+// print all characters of the queue on the display
+// The characters are collected and printed with
+// tb_display_print_bytes, so the screen is drawn once per chunk.
+// =============================================================
+size_t tb_display_queue_process(){
+  size_t count = 0;
+  uint8_t text[QUEUE_CHUNK];
+  int length = 0;
+  char data = 0;
+  bool more = true;
+  while(more){
+    more = tb_display_queue_pop(&data);
+    if(more){
+      count++;
+      if(data != 8 && data != '\0'){
+        text[length++] = data;
+        if(length < QUEUE_CHUNK)
+          continue;
+      }
+    }
+    bool delete_char = more && data == 8;
+    if(length > 0 || delete_char){
+      tb_display_lock();
+      if(length > 0)
+        tb_display_print_bytes(text, length);
+      if(delete_char)
+        tb_display_delete_char();
+      tb_display_unlock();
+      length = 0;
+    }
+  }
+  return count;
+}
+
+// =============================================================
+// statistics of the queue
+// =============================================================
+uint32_t tb_display_queue_fill(){
+  return queue_head.load(std::memory_order_relaxed) - queue_tail.load(std::memory_order_relaxed);
+}
+
+uint32_t tb_display_queue_max_fill(){
+  return queue_max_fill.load(std::memory_order_relaxed);
+}
+
+uint32_t tb_display_queue_dropped(){
+  return queue_dropped.load(std::memory_order_relaxed);
+}
+
+uint32_t tb_display_queue_overflows(){
+  return queue_overflows.load(std::memory_order_relaxed);
+}
+
+// =============================================================
+// the render task
+// prints the characters of the queue until it is stopped
+// With a limited frame rate (tb_display_set_frame_rate), the
+// task also draws the frames.
+// =============================================================
+static void tb_display_render_loop(){
+  while(!render_task_stop.load()){
+    size_t count = tb_display_queue_process();
+    tb_display_lock();
+    bool drawn = tb_display_update();
+    tb_display_unlock();
+    if(count == 0 && !drawn)
+      delay(1);
+  }
+}
+
+#ifdef TB_DISPLAY_HOST
+
+bool tb_display_render_task_begin(){
+  if(render_task_running.load())
+    return true;
+  render_task_stop.store(false);
+  render_thread = std::thread(tb_display_render_loop);
+  render_task_running.store(true);
+  return true;
+}
+
+void tb_display_render_task_end(){
+  if(!render_task_running.load())
+    return;
+  render_task_stop.store(true);
+  render_thread.join();
+  render_task_running.store(false);
+}
+
+void tb_display_lock(){
+  display_mutex.lock();
+}
+
+void tb_display_unlock(){
+  display_mutex.unlock();
+}
+
+#else
+
+static void tb_display_render_task(void *parameter){
+  tb_display_render_loop();
+  render_task_running.store(false);
+  vTaskDelete(NULL);
+}
+
+// =============================================================
+// start the render task on the core TB_DISPLAY_RENDER_CORE
+// =============================================================
+bool tb_display_render_task_begin(){
+  if(render_task_running.load())
+    return true;
+  if(display_mutex == NULL)
+    display_mutex = xSemaphoreCreateMutex();
+  if(display_mutex == NULL)
+    return false;
+  render_task_stop.store(false);
+  render_task_running.store(true);
+  if(xTaskCreatePinnedToCore(tb_display_render_task, "tb_display", TB_DISPLAY_RENDER_STACK,
+                             NULL, TB_DISPLAY_RENDER_PRIORITY, NULL, TB_DISPLAY_RENDER_CORE) != pdPASS){
+    render_task_running.store(false);
+    return false;
+  }
+  return true;
+}
+
+// =============================================================
+// stop the render task
+// waits until the task has finished the actual characters
+// =============================================================
+void tb_display_render_task_end(){
+  render_task_stop.store(true);
+  while(render_task_running.load())
+    delay(1);
+}
+
+// =============================================================
+// exclusive use of the display
+// Without the render task (no mutex), nothing has to be locked.
+// =============================================================
+void tb_display_lock(){
+  if(display_mutex != NULL)
+    xSemaphoreTake(display_mutex, portMAX_DELAY);
+}
+
+void tb_display_unlock(){
+  if(display_mutex != NULL)
+    xSemaphoreGive(display_mutex);
+}
+
+#endif // TB_DISPLAY_HOST
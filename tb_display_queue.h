@@ -0,0 +1,121 @@
+/******************************************************************************
+ * tb_display_queue.h
+ * Input queue and render task of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The characters for the display can be pushed into a queue from any
+ * task without waiting for the drawing. The queue is a lock-free ring
+ * of bytes: several tasks can push at the same time (the drawing task
+ * is the only one that takes characters out). If the queue is full,
+ * the characters are dropped and counted.
+ * A render task on the other core of the ESP32 takes the characters
+ * out of the queue and prints them on the display. So the loop() does
+ * not stop while the screen is drawn. With a limited frame rate
+ * (tb_display_set_frame_rate), the render task also calls
+ * tb_display_update().
+ * The size of the queue and the core of the render task are set in
+ * tb_display_config.h.
+ *
+ * With the render task running, all other tb_display functions must be
+ * called between tb_display_lock() and tb_display_unlock().
+ *
+ * On a host (build flag TB_DISPLAY_HOST), the render task is a
+ * std::thread, so the queue can be checked with several std::thread
+ * producers.
+ * tb_serial_replay.cpp measures the throughput of the serial input
+ * through the queue on a host.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_QUEUE_H
+#define TB_DISPLAY_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================
+//           tb_display_queue_push(char data);
+// add a character to the queue
+// Never waits. Can be called from any task at the same time.
+// The backspace character (8) deletes the last character.
+// returns false if the queue is full (the character is dropped)
+// example:
+//    while(Serial.available() > 0)
+//      tb_display_queue_push(Serial.read());
+// =============================================================
+bool tb_display_queue_push(char data);
+
+// =============================================================
+//           tb_display_queue_push_String(const char *s);
+// add a string to the queue
+// The characters that do not fit into the queue are dropped.
+// returns the number of characters added to the queue
+// =============================================================
+size_t tb_display_queue_push_String(const char *s);
+
+// =============================================================
+//           tb_display_queue_push_bytes(const uint8_t *data, size_t length);
+// add a block of characters to the queue
+// The space in the queue is reserved once for the whole block.
+// The characters that do not fit into the queue are dropped.
+// returns the number of characters added to the queue
+// example:
+//    uint8_t buffer[256];
+//    size_t length = Serial.readBytes(buffer, sizeof(buffer));
+//    tb_display_queue_push_bytes(buffer, length);
+// =============================================================
+size_t tb_display_queue_push_bytes(const uint8_t *data, size_t length);
+
+// =============================================================
+//           tb_display_queue_process();
+// print all characters of the queue on the display
+// This is done by the render task. Without the render task, call it
+// from the loop(). Only one task may take characters out of the queue.
+// returns the number of processed characters
+// =============================================================
+size_t tb_display_queue_process();
+
+// =============================================================
+//           tb_display_queue_...
+// statistics of the queue
+// fill      = number of characters waiting in the queue
+// max_fill  = highest number of waiting characters so far
+// dropped   = number of characters dropped because the queue was full
+// overflows = number of push calls that found the queue full
+// =============================================================
+uint32_t tb_display_queue_fill();
+uint32_t tb_display_queue_max_fill();
+uint32_t tb_display_queue_dropped();
+uint32_t tb_display_queue_overflows();
+
+// =============================================================
+//           tb_display_render_task_begin();
+// start the render task on the core TB_DISPLAY_RENDER_CORE
+// Call it after tb_display_init().
+// returns false if the task could not be started
+// =============================================================
+bool tb_display_render_task_begin();
+
+// =============================================================
+//           tb_display_render_task_end();
+// stop the render task
+// The characters left in the queue stay there.
+// =============================================================
+void tb_display_render_task_end();
+
+// =============================================================
+//           tb_display_lock();
+//           tb_display_unlock();
+// exclusive use of the display
+// While the render task is running, the other tb_display functions
+// must be called between lock and unlock.
+// example:
+//    tb_display_lock();
+//    tb_display_page_up();
+//    tb_display_unlock();
+// =============================================================
+void tb_display_lock();
+void tb_display_unlock();
+
+#endif // TB_DISPLAY_QUEUE_H
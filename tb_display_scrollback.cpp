@@ -0,0 +1,174 @@
+/******************************************************************************
+ * tb_display_scrollback.cpp
+ * Scrollback history of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include <stdlib.h>
+#include "tb_display_config.h"
+#include "tb_display_scrollback.h"
+
+#if TB_DISPLAY_SCROLLBACK_LINES > 0 && TB_DISPLAY_SCROLLBACK_BYTES > 0
+
+// the longest row (row end, characters and null terminator)
+// must fit into the memory
+#if TB_DISPLAY_SCROLLBACK_BYTES < TEXT_BUFFER_LINE_LENGTH_WIDE+1
+  #error "TB_DISPLAY_SCROLLBACK_BYTES is smaller than a row"
+#endif
+
+// the characters of all rows
+static char *scrollback_data = NULL;
+// the start of each row in scrollback_data
+// The positions and row numbers are counted up all the time.
+// Modulo operations give the index in the arrays.
+static uint32_t *scrollback_start = NULL;
+// the first (oldest) row and the row behind the last row
+static uint32_t scrollback_first = 0;
+static uint32_t scrollback_next = 0;
+// position for the next row in scrollback_data
+static uint32_t scrollback_head = 0;
+
+// =============================================================
+// allocate the memory of the history
+// =============================================================
+bool tb_display_scrollback_begin(){
+  if(scrollback_data == NULL){
+#ifdef BOARD_HAS_PSRAM
+    scrollback_data = (char*)ps_malloc(TB_DISPLAY_SCROLLBACK_BYTES);
+    scrollback_start = (uint32_t*)ps_malloc(TB_DISPLAY_SCROLLBACK_LINES*sizeof(uint32_t));
+#else
+    scrollback_data = (char*)malloc(TB_DISPLAY_SCROLLBACK_BYTES);
+    scrollback_start = (uint32_t*)malloc(TB_DISPLAY_SCROLLBACK_LINES*sizeof(uint32_t));
+#endif
+    if(scrollback_data == NULL || scrollback_start == NULL){
+      free(scrollback_data);
+      free(scrollback_start);
+      scrollback_data = NULL;
+      scrollback_start = NULL;
+      return false;
+    }
+    tb_display_scrollback_clear();
+  }
+  return true;
+}
+
+// =============================================================
+// remove all rows from the history
+// =============================================================
+void tb_display_scrollback_clear(){
+  scrollback_first = 0;
+  scrollback_next = 0;
+  scrollback_head = 0;
+}
+
+// =============================================================
+// add a row at the end of the history
+// =============================================================
+void tb_display_scrollback_append(const char *row, uint8_t row_end){
+  if(scrollback_data == NULL)
+    return;
+  // the row end, the characters and the null terminator
+  uint32_t length = strlen(row) + 2;
+  uint32_t start = scrollback_head;
+  // a row is never split at the end of the memory
+  if(start % TB_DISPLAY_SCROLLBACK_BYTES + length > TB_DISPLAY_SCROLLBACK_BYTES)
+    start += TB_DISPLAY_SCROLLBACK_BYTES - start % TB_DISPLAY_SCROLLBACK_BYTES;
+  scrollback_head = start + length;
+  // remove the oldest rows if there is no space anymore
+  if(scrollback_next - scrollback_first >= TB_DISPLAY_SCROLLBACK_LINES)
+    scrollback_first++;
+  while(scrollback_first != scrollback_next &&
+        scrollback_head - scrollback_start[scrollback_first % TB_DISPLAY_SCROLLBACK_LINES] > TB_DISPLAY_SCROLLBACK_BYTES)
+    scrollback_first++;
+  scrollback_start[scrollback_next % TB_DISPLAY_SCROLLBACK_LINES] = start;
+  scrollback_next++;
+  scrollback_data[start % TB_DISPLAY_SCROLLBACK_BYTES] = row_end;
+  memcpy(scrollback_data + start % TB_DISPLAY_SCROLLBACK_BYTES + 1, row, length-1);
+  // count down before the counters overflow (after some days of logging)
+  // by a multiple of the array sizes, so the modulo results stay the same
+  if(scrollback_head >= 0x80000000UL){
+    uint32_t rebase = scrollback_start[scrollback_first % TB_DISPLAY_SCROLLBACK_LINES];
+    rebase -= rebase % TB_DISPLAY_SCROLLBACK_BYTES;
+    for(uint32_t n = scrollback_first; n != scrollback_next; n++)
+      scrollback_start[n % TB_DISPLAY_SCROLLBACK_LINES] -= rebase;
+    scrollback_head -= rebase;
+  }
+  if(scrollback_next >= 0x80000000UL){
+    uint32_t rebase = scrollback_first - scrollback_first % TB_DISPLAY_SCROLLBACK_LINES;
+    scrollback_first -= rebase;
+    scrollback_next -= rebase;
+  }
+}
+
+// =============================================================
+// remove the last row from the history
+// =============================================================
+void tb_display_scrollback_pop(){
+  if(scrollback_next == scrollback_first)
+    return;
+  scrollback_next--;
+  scrollback_head = scrollback_start[scrollback_next % TB_DISPLAY_SCROLLBACK_LINES];
+}
+
+// =============================================================
+// number of rows in the history
+// =============================================================
+int tb_display_scrollback_count(){
+  return scrollback_next - scrollback_first;
+}
+
+// =============================================================
+// a row of the history (0 = the oldest row)
+// =============================================================
+const char *tb_display_scrollback_row(int n){
+  uint32_t start = scrollback_start[(scrollback_first + n) % TB_DISPLAY_SCROLLBACK_LINES];
+  return scrollback_data + start % TB_DISPLAY_SCROLLBACK_BYTES + 1;
+}
+
+// =============================================================
+// how a row of the history ends
+// =============================================================
+uint8_t tb_display_scrollback_row_end(int n){
+  uint32_t start = scrollback_start[(scrollback_first + n) % TB_DISPLAY_SCROLLBACK_LINES];
+  return scrollback_data[start % TB_DISPLAY_SCROLLBACK_BYTES];
+}
+
+#else
+
+// =============================================================
+// no history: TB_DISPLAY_SCROLLBACK_LINES or
+// TB_DISPLAY_SCROLLBACK_BYTES is 0
+// =============================================================
+bool tb_display_scrollback_begin(){
+  return false;
+}
+
+void tb_display_scrollback_clear(){
+}
+
+void tb_display_scrollback_append(const char *, uint8_t){
+}
+
+void tb_display_scrollback_pop(){
+}
+
+int tb_display_scrollback_count(){
+  return 0;
+}
+
+const char *tb_display_scrollback_row(int){
+  return "";
+}
+
+uint8_t tb_display_scrollback_row_end(int){
+  return 0;
+}
+
+#endif
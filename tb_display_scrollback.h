@@ -0,0 +1,55 @@
+/******************************************************************************
+ * tb_display_scrollback.h
+ * Scrollback history of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Every row that scrolls out of the top of the screen is added to the
+ * history. The rows on the screen can still change (escape sequences,
+ * line editing), so they are added only when they leave the screen.
+ * The rows are stored one after another (with a null terminator) in a
+ * ring of bytes, so a short row needs only a few bytes.
+ * The oldest rows are removed if the memory or the number of rows
+ * is used up. A row is never split at the end of the ring, so every
+ * row can be drawn directly from the history without a copy.
+ * One byte in front of each row keeps how the row ends (TB_ROW_END,
+ * TB_ROW_WRAP or TB_ROW_SPACE, see tb_display_viewport.h), so the
+ * wrapped rows can be joined to logical lines again.
+ * The size is set in tb_display_config.h:
+ *   TB_DISPLAY_SCROLLBACK_LINES = maximum number of rows (0 = no history)
+ *   TB_DISPLAY_SCROLLBACK_BYTES = memory for the characters of the rows
+ *                                 (0 = no history)
+ * The memory is taken from PSRAM if available.
+ *
+ * These functions are used by tb_display.cpp. To show the history
+ * on the screen, use tb_display_scroll_back() and the page functions.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_SCROLLBACK_H
+#define TB_DISPLAY_SCROLLBACK_H
+
+// allocate the memory of the history
+// returns false if there is not enough memory (or no history is configured)
+bool tb_display_scrollback_begin();
+
+// remove all rows from the history
+void tb_display_scrollback_clear();
+
+// add a row at the end of the history
+// row_end = how the row ends (TB_ROW_END, ...)
+void tb_display_scrollback_append(const char *row, uint8_t row_end);
+
+// remove the last row from the history
+void tb_display_scrollback_pop();
+
+// number of rows in the history
+int tb_display_scrollback_count();
+
+// a row of the history (0 = the oldest row)
+const char *tb_display_scrollback_row(int n);
+
+// how a row of the history ends (TB_ROW_END, ...)
+uint8_t tb_display_scrollback_row_end(int n);
+
+#endif // TB_DISPLAY_SCROLLBACK_H
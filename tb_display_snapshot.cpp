@@ -0,0 +1,214 @@
+/******************************************************************************
+ * tb_display_snapshot.cpp
+ * Snapshot of the text buffer display in the RTC memory.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+  // the RTC memory is a normal array on the host
+  #define SNAPSHOT_RTC_MEMORY
+#else
+  #include <Arduino.h>
+  // kept in the deep sleep, cleared at power on and reset
+  #define SNAPSHOT_RTC_MEMORY RTC_DATA_ATTR
+#endif
+#include <string.h>
+#include "tb_display_config.h"
+#include "tb_display_viewport.h"
+#include "tb_display_snapshot.h"
+
+// the first bytes of a snapshot
+#define SNAPSHOT_MAGIC_1 'T'
+#define SNAPSHOT_MAGIC_2 'B'
+// change the version with a new format of the snapshot
+// or of the text buffer
+#define SNAPSHOT_VERSION 1
+// magic (2 bytes), version, rows, line_length, read_pointer_y,
+// write_pointer_y, write_pointer_x, length of the rows (2 bytes), CRC-32
+#define SNAPSHOT_HEADER 14
+#define SNAPSHOT_CRC 10
+// the row end byte of a row with colors
+#define SNAPSHOT_ROW_ATTR 0x80
+
+#if TB_DISPLAY_SNAPSHOT_BYTES < SNAPSHOT_HEADER
+  #error "TB_DISPLAY_SNAPSHOT_BYTES is too small"
+#endif
+
+// the snapshot:
+//   header
+//   each row of the text buffer (in the order of the memory):
+//     row end (TB_ROW_END, ...), + SNAPSHOT_ROW_ATTR with colors
+//     number of characters
+//     characters
+//     colors of the characters (only with SNAPSHOT_ROW_ATTR)
+static SNAPSHOT_RTC_MEMORY uint8_t snapshot_memory[TB_DISPLAY_SNAPSHOT_BYTES];
+// the first tb_display_init() after the start has looked for a snapshot
+// (in the normal RAM, so it is false again after the deep sleep)
+static bool snapshot_checked = false;
+
+// =============================================================
+// CRC-32 of the bytes "start" to "end" of the snapshot
+// =============================================================
+static uint32_t tb_display_snapshot_crc_add(uint32_t crc, uint32_t start, uint32_t end){
+  for(uint32_t n = start; n < end; n++){
+    crc ^= snapshot_memory[n];
+    for(int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+// =============================================================
+// CRC-32 of the snapshot without the magic and the CRC itself
+// =============================================================
+static uint32_t tb_display_snapshot_crc(){
+  uint32_t length = snapshot_memory[8] | (snapshot_memory[9] << 8);
+  uint32_t crc = tb_display_snapshot_crc_add(0xFFFFFFFF, 2, SNAPSHOT_CRC);
+  crc = tb_display_snapshot_crc_add(crc, SNAPSHOT_HEADER, SNAPSHOT_HEADER + length);
+  return ~crc;
+}
+
+// =============================================================
+// copy the rows of the screen into the RTC memory
+// =============================================================
+bool tb_display_snapshot_save(){
+  tb_display_viewport *vp = tb_display_screen_viewport();
+  // no valid snapshot while it is written
+  snapshot_memory[0] = 0;
+  if(vp->text == NULL)
+    return false;
+  int length = 0;
+  uint8_t *rows = snapshot_memory + SNAPSHOT_HEADER;
+  for(int line = 0; line < vp->rows; line++){
+    const char *text = vp->text + line*vp->line_length;
+    const uint8_t *attr = vp->attr + line*vp->line_length;
+    int chars = strlen(text);
+    // the colors only if they are not the default colors
+    bool colors = false;
+    for(int charpos = 0; charpos < chars; charpos++)
+      if(attr[charpos] != TB_ATTR_DEFAULT)
+        colors = true;
+    if(SNAPSHOT_HEADER + length + 2 + chars*(colors ? 2 : 1) > TB_DISPLAY_SNAPSHOT_BYTES)
+      return false;
+    rows[length++] = vp->row_end[line] | (colors ? SNAPSHOT_ROW_ATTR : 0);
+    rows[length++] = chars;
+    memcpy(rows + length, text, chars);
+    length += chars;
+    if(colors){
+      memcpy(rows + length, attr, chars);
+      length += chars;
+    }
+  }
+  snapshot_memory[2] = SNAPSHOT_VERSION;
+  snapshot_memory[3] = vp->rows;
+  snapshot_memory[4] = vp->line_length;
+  snapshot_memory[5] = vp->read_pointer_y;
+  snapshot_memory[6] = vp->write_pointer_y;
+  snapshot_memory[7] = vp->write_pointer_x;
+  snapshot_memory[8] = length & 0xFF;
+  snapshot_memory[9] = length >> 8;
+  snapshot_memory[1] = SNAPSHOT_MAGIC_2;
+  uint32_t crc = tb_display_snapshot_crc();
+  for(int n = 0; n < 4; n++)
+    snapshot_memory[SNAPSHOT_CRC+n] = crc >> (8*n);
+  snapshot_memory[0] = SNAPSHOT_MAGIC_1;
+  return true;
+}
+
+// =============================================================
+// the RTC memory holds a complete snapshot of this version
+// =============================================================
+bool tb_display_snapshot_valid(){
+  if(snapshot_memory[0] != SNAPSHOT_MAGIC_1 || snapshot_memory[1] != SNAPSHOT_MAGIC_2 ||
+     snapshot_memory[2] != SNAPSHOT_VERSION)
+    return false;
+  uint32_t length = snapshot_memory[8] | (snapshot_memory[9] << 8);
+  if(SNAPSHOT_HEADER + length > TB_DISPLAY_SNAPSHOT_BYTES)
+    return false;
+  uint32_t crc = 0;
+  for(int n = 0; n < 4; n++)
+    crc |= (uint32_t)snapshot_memory[SNAPSHOT_CRC+n] << (8*n);
+  return crc == tb_display_snapshot_crc();
+}
+
+// =============================================================
+// the snapshot is not used anymore
+// =============================================================
+void tb_display_snapshot_discard(){
+  snapshot_memory[0] = 0;
+}
+
+// =============================================================
+// copy the snapshot into the cleared text buffer
+// =============================================================
+bool tb_display_snapshot_load(tb_display_viewport *vp){
+  // only after the start, a later tb_display_init() keeps the snapshot
+  if(snapshot_checked)
+    return false;
+  snapshot_checked = true;
+  bool valid = tb_display_snapshot_valid();
+  // used only once
+  tb_display_snapshot_discard();
+  if(!valid || snapshot_memory[3] != vp->rows || snapshot_memory[4] != vp->line_length ||
+     snapshot_memory[5] >= vp->rows || snapshot_memory[6] >= vp->rows ||
+     snapshot_memory[7] >= vp->line_length)
+    return false;
+  // check all rows first, the text buffer stays empty
+  // if the snapshot does not fit
+  int length = snapshot_memory[8] | (snapshot_memory[9] << 8);
+  const uint8_t *rows = snapshot_memory + SNAPSHOT_HEADER;
+  int pos = 0;
+  for(int line = 0; line < vp->rows; line++){
+    if(pos + 2 > length)
+      return false;
+    int chars = rows[pos+1];
+    int bytes = (rows[pos] & SNAPSHOT_ROW_ATTR) ? 2*chars : chars;
+    if(chars >= vp->line_length || pos + 2 + bytes > length)
+      return false;
+    pos += 2 + bytes;
+  }
+  pos = 0;
+  for(int line = 0; line < vp->rows; line++){
+    char *text = vp->text + line*vp->line_length;
+    uint8_t *attr = vp->attr + line*vp->line_length;
+    bool colors = (rows[pos] & SNAPSHOT_ROW_ATTR) != 0;
+    vp->row_end[line] = rows[pos++] & ~SNAPSHOT_ROW_ATTR;
+    int chars = rows[pos++];
+    memcpy(text, rows + pos, chars);
+    text[chars] = '\0';
+    pos += chars;
+    if(colors){
+      memcpy(attr, rows + pos, chars);
+      pos += chars;
+    } else {
+      memset(attr, TB_ATTR_DEFAULT, chars);
+    }
+  }
+  vp->read_pointer_y = snapshot_memory[5];
+  vp->write_pointer_y = snapshot_memory[6];
+  vp->write_pointer_x = snapshot_memory[7];
+  // the write position is inside of the row
+  int chars = strlen(vp->text + vp->write_pointer_y*vp->line_length);
+  if(vp->write_pointer_x > chars)
+    vp->write_pointer_x = chars;
+  return true;
+}
+
+// =============================================================
+// the RTC memory of the snapshot
+// =============================================================
+uint8_t *tb_display_snapshot_memory(){
+  return snapshot_memory;
+}
+
+#ifdef TB_DISPLAY_HOST
+// =============================================================
+// the next tb_display_init() is the first one after a start
+// =============================================================
+void tb_display_snapshot_wake_up(){
+  snapshot_checked = false;
+}
+#endif
@@ -0,0 +1,93 @@
+/******************************************************************************
+ * tb_display_snapshot.h
+ * Snapshot of the text buffer display in the RTC memory.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * In the deep sleep, the RAM of the ESP32 is lost, only the RTC slow
+ * memory keeps its content. tb_display_snapshot_save() copies the
+ * rows of the screen, their colors and the read and write positions
+ * into the RTC memory, only the used characters of each row.
+ * After the wake up, setup() calls tb_display_init() as after every
+ * start. If there is a valid snapshot, tb_display_init() restores the
+ * rows instead of clearing them and draws the screen once. Otherwise
+ * the screen is empty as before.
+ * example:
+ *    tb_display_snapshot_save();
+ *    esp_deep_sleep_start();
+ *    ...
+ *    void setup(){
+ *      tb_display_init(3); // shows the rows before the deep sleep
+ *
+ * The snapshot has a version tag and a CRC-32. It is used only once
+ * and only with the same number of rows and row length (the same
+ * orientation, landscape or portrait, and the same status rows).
+ * Only the first tb_display_init() after the start restores the
+ * snapshot. A later tb_display_init() clears the screen and keeps the
+ * snapshot for the next start. A snapshot saved in another orientation
+ * than the one of the first tb_display_init() (e.g. after a rotation)
+ * is dropped at the wake up.
+ * The scrollback history, the line editor and the escape sequence
+ * state are not saved.
+ * The memory is set with TB_DISPLAY_SNAPSHOT_BYTES in
+ * tb_display_config.h. On a Linux host (TB_DISPLAY_HOST), it is a
+ * normal array that keeps its content while the program runs.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_SNAPSHOT_H
+#define TB_DISPLAY_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "tb_display_viewport.h"
+
+// =============================================================
+//           tb_display_snapshot_save();
+// copy the rows of the screen into the RTC memory
+// Call it right before the deep sleep. With the render task, call
+// it between tb_display_lock() and tb_display_unlock().
+// returns false if the rows do not fit into the RTC memory
+// =============================================================
+bool tb_display_snapshot_save();
+
+// =============================================================
+//           tb_display_snapshot_valid();
+// returns true if the RTC memory holds a snapshot
+// =============================================================
+bool tb_display_snapshot_valid();
+
+// =============================================================
+//           tb_display_snapshot_discard();
+// the next tb_display_init() starts with an empty screen
+// =============================================================
+void tb_display_snapshot_discard();
+
+// =============================================================
+//           tb_display_snapshot_load(vp);
+// copy the snapshot into the cleared text buffer of the viewport
+// and discard it (used by tb_display_init)
+// Only the first call after the start loads the snapshot.
+// The rows have to be laid out afterwards.
+// returns false if there is no valid snapshot for the size of the
+// text buffer or if it is not the first call
+// =============================================================
+bool tb_display_snapshot_load(tb_display_viewport *vp);
+
+// =============================================================
+//           tb_display_snapshot_memory();
+// the RTC memory of the snapshot (TB_DISPLAY_SNAPSHOT_BYTES)
+// e.g. to simulate a deep sleep or a damaged snapshot on a host
+// =============================================================
+uint8_t *tb_display_snapshot_memory();
+
+#ifdef TB_DISPLAY_HOST
+// =============================================================
+//           tb_display_snapshot_wake_up();
+// simulates the start after the deep sleep on a host: the next
+// tb_display_init() restores the snapshot again
+// =============================================================
+void tb_display_snapshot_wake_up();
+#endif
+
+#endif // TB_DISPLAY_SNAPSHOT_H
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * tb_display_stats.cpp
+ * Counters and timing of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include "tb_display_stats.h"
+
+// all values are 0 at the start
+tb_display_statistics tb_display_statistic_values;
+
+// =============================================================
+// returns the counters and histograms
+// =============================================================
+const tb_display_statistics *tb_display_stats(){
+  return &tb_display_statistic_values;
+}
+
+// =============================================================
+// set all counters and histograms to 0
+// =============================================================
+void tb_display_stats_reset(){
+  memset(&tb_display_statistic_values, 0, sizeof(tb_display_statistic_values));
+}
+
+// =============================================================
+// returns the average time in microseconds
+// =============================================================
+uint32_t tb_display_stats_average(const tb_display_histogram *h){
+  if(h->count == 0)
+    return 0;
+  return (uint32_t)(h->sum / h->count);
+}
+
+// =============================================================
+// add a time to a histogram
+// =============================================================
+void tb_display_stats_record(tb_display_histogram *h, uint32_t us){
+  if(h->count == 0 || us < h->min)
+    h->min = us;
+  if(us > h->max)
+    h->max = us;
+  h->count++;
+  h->sum += us;
+  int bucket = 0;
+  while(us > 1 && bucket < TB_DISPLAY_STATS_BUCKETS-1){
+    us >>= 1;
+    bucket++;
+  }
+  h->buckets[bucket]++;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * tb_display_stats.h
+ * Counters and timing of the text buffer scrolling display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The library counts what it sends to the screen and measures the
+ * time of tb_display_show(), of each refresh and of each printed
+ * character:
+ *   draw_chars        = characters drawn by the backend
+ *                       (on the screen and in the row sprite)
+ *   pixels            = pixels sent to the screen (2 bytes each)
+ *   full_refreshes    = refreshes that redraw all rows
+ *   partial_refreshes = refreshes that redraw only some rows
+ *   wrap_backtracks   = words moved into the next row by Word-Wrap
+ *   wrap_moved        = characters moved by Word-Wrap
+ *   show_time         = time of tb_display_show() in microseconds
+ *   refresh_time      = time of a refresh of the changed rows in
+ *                       microseconds (tb_display_refresh(), the
+ *                       frames of tb_display_update() and the drawing
+ *                       after each change without a frame rate)
+ *   char_time         = time of tb_display_print_char() in microseconds
+ * The times are collected in histograms with the buckets
+ * 0-1, 2-3, 4-7, 8-15, ... microseconds.
+ *
+ * The counting is removed from the library with
+ *    #define TB_DISPLAY_STATS 0
+ * (tb_display_config.h or a build flag). Then, all values stay 0.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_STATS_H
+#define TB_DISPLAY_STATS_H
+
+#include <stdint.h>
+#include "tb_display_config.h"
+
+// number of buckets of a histogram
+// the last bucket counts all longer times
+#define TB_DISPLAY_STATS_BUCKETS 16
+
+// times in microseconds
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  // bucket n counts the times from 2^n to 2^(n+1)-1
+  // (bucket 0 also counts 0)
+  uint32_t buckets[TB_DISPLAY_STATS_BUCKETS];
+} tb_display_histogram;
+
+typedef struct {
+  uint32_t draw_chars;
+  uint64_t pixels;
+  uint32_t full_refreshes;
+  uint32_t partial_refreshes;
+  uint32_t wrap_backtracks;
+  uint32_t wrap_moved;
+  tb_display_histogram show_time;
+  tb_display_histogram refresh_time;
+  tb_display_histogram char_time;
+} tb_display_statistics;
+
+// =============================================================
+//           tb_display_stats();
+// returns the counters and histograms
+// With the render task, read them between tb_display_lock()
+// and tb_display_unlock().
+// example:
+//    tb_display_lock();
+//    tb_display_statistics stats = *tb_display_stats();
+//    tb_display_unlock();
+// =============================================================
+const tb_display_statistics *tb_display_stats();
+
+// =============================================================
+//           tb_display_stats_reset();
+// set all counters and histograms to 0
+// =============================================================
+void tb_display_stats_reset();
+
+// =============================================================
+//           tb_display_stats_average(const tb_display_histogram *h);
+// returns the average time in microseconds (0 without values)
+// =============================================================
+uint32_t tb_display_stats_average(const tb_display_histogram *h);
+
+// =============================================================
+// the counting in the library
+// =============================================================
+void tb_display_stats_record(tb_display_histogram *h, uint32_t us);
+#if TB_DISPLAY_STATS
+  extern tb_display_statistics tb_display_statistic_values;
+  // measures the time until the end of the block
+  class tb_display_stats_timer {
+  public:
+    tb_display_stats_timer(tb_display_histogram *histogram) : h(histogram), start(micros()) {}
+    ~tb_display_stats_timer(){ tb_display_stats_record(h, micros() - start); }
+  private:
+    tb_display_histogram *h;
+    unsigned long start;
+  };
+  #define TB_STATS_ADD(counter, n) (tb_display_statistic_values.counter += (n))
+  #define TB_STATS_TIME(histogram) tb_display_stats_timer tb_stats_timer(&tb_display_statistic_values.histogram)
+#else
+  #define TB_STATS_ADD(counter, n) ((void)0)
+  #define TB_STATS_TIME(histogram) ((void)0)
+#endif
+
+#endif // TB_DISPLAY_STATS_H
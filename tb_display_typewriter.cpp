@@ -0,0 +1,137 @@
+/******************************************************************************
+ * tb_display_typewriter.cpp
+ * Typewriter effect of the text buffer scrolling display without delay().
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+  #include "tb_display_host.h"
+#else
+  #include <Arduino.h>
+#endif
+#include "tb_display.h"
+#include "tb_display_config.h"
+#include "tb_display_typewriter.h"
+
+// characters printed with one tb_display_print_String
+#define TYPEWRITER_CHUNK 64
+
+// the characters of all waiting strings (a ring)
+static char typewriter_text[TB_DISPLAY_TYPEWRITER_BYTES];
+static int typewriter_text_start = 0;
+static int typewriter_text_count = 0;
+// the waiting strings (a ring):
+// the characters left and the delay of each string
+static int typewriter_length[TB_DISPLAY_TYPEWRITER_STRINGS];
+static int typewriter_delay[TB_DISPLAY_TYPEWRITER_STRINGS];
+static int typewriter_first = 0;
+static int typewriter_count = 0;
+// time of the last typed character
+static unsigned long typewriter_last = 0;
+
+// =============================================================
+// take the next character of the first waiting string
+// =============================================================
+static char tb_display_typewriter_next(){
+  char data = typewriter_text[typewriter_text_start];
+  typewriter_text_start = (typewriter_text_start + 1) % TB_DISPLAY_TYPEWRITER_BYTES;
+  typewriter_text_count--;
+  typewriter_length[typewriter_first]--;
+  if(typewriter_length[typewriter_first] == 0){
+    typewriter_first = (typewriter_first + 1) % TB_DISPLAY_TYPEWRITER_STRINGS;
+    typewriter_count--;
+  }
+  return data;
+}
+
+// =============================================================
+// print the rest of the first waiting string at once
+// all = true: print all waiting strings
+// =============================================================
+static void tb_display_typewriter_print(bool all){
+  char text[TYPEWRITER_CHUNK+1];
+  int length = 0;
+  int entry = typewriter_first;
+  while(typewriter_count > 0 && (all || typewriter_first == entry)){
+    text[length++] = tb_display_typewriter_next();
+    if(length == TYPEWRITER_CHUNK){
+      text[length] = '\0';
+      tb_display_print_String(text);
+      length = 0;
+    }
+  }
+  if(length > 0){
+    text[length] = '\0';
+    tb_display_print_String(text);
+  }
+}
+
+// =============================================================
+// add a string to the typewriter queue
+// =============================================================
+bool tb_display_type_String(const char *s, int chr_delay){
+  int length = strlen(s);
+  if(length == 0)
+    return true;
+  if(typewriter_count >= TB_DISPLAY_TYPEWRITER_STRINGS ||
+     typewriter_text_count + length > TB_DISPLAY_TYPEWRITER_BYTES)
+    return false;
+  int entry = (typewriter_first + typewriter_count) % TB_DISPLAY_TYPEWRITER_STRINGS;
+  typewriter_length[entry] = length;
+  typewriter_delay[entry] = chr_delay > 0 ? chr_delay : 0;
+  typewriter_count++;
+  int pos = (typewriter_text_start + typewriter_text_count) % TB_DISPLAY_TYPEWRITER_BYTES;
+  for(int n=0; n<length; n++){
+    typewriter_text[pos] = s[n];
+    pos = (pos + 1) % TB_DISPLAY_TYPEWRITER_BYTES;
+  }
+  typewriter_text_count += length;
+  return true;
+}
+
+// =============================================================
+// print the next characters if they are due
+// Only one character is typed per call, so the loop() is never
+// stopped for longer than drawing one character.
+// =============================================================
+void tb_display_typewriter_tick(){
+  while(typewriter_count > 0){
+    if(typewriter_delay[typewriter_first] == 0){
+      // strings without delay are printed at once
+      tb_display_typewriter_print(false);
+      continue;
+    }
+    unsigned long now = millis();
+    if(now - typewriter_last < (unsigned long)typewriter_delay[typewriter_first])
+      return;
+    typewriter_last = now;
+    tb_display_print_char(tb_display_typewriter_next());
+    return;
+  }
+}
+
+// =============================================================
+// number of characters waiting to be typed
+// =============================================================
+int tb_display_typewriter_pending(){
+  return typewriter_text_count;
+}
+
+// =============================================================
+// print all waiting characters immediately
+// =============================================================
+void tb_display_typewriter_flush(){
+  tb_display_typewriter_print(true);
+}
+
+// =============================================================
+// remove all waiting characters
+// =============================================================
+void tb_display_typewriter_clear(){
+  typewriter_text_start = 0;
+  typewriter_text_count = 0;
+  typewriter_first = 0;
+  typewriter_count = 0;
+}
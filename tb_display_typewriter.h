@@ -0,0 +1,61 @@
+/******************************************************************************
+ * tb_display_typewriter.h
+ * Typewriter effect of the text buffer scrolling display without delay().
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * tb_display_print_String(s, chr_delay) waits chr_delay milliseconds
+ * after every character, so nothing else can be done in the meantime.
+ * Here, the strings are copied into a queue and the characters are
+ * printed one by one from tb_display_typewriter_tick(), which is called
+ * in the loop(). It checks with millis() if the next character is due
+ * and returns immediately otherwise.
+ * Several strings can be waiting; they are typed one after another.
+ * tb_display_print_char() and tb_display_print_String() still print
+ * immediately, so their text appears between the typed characters.
+ * The size of the queue is set in tb_display_config.h.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_TYPEWRITER_H
+#define TB_DISPLAY_TYPEWRITER_H
+
+// =============================================================
+//           tb_display_type_String(const char *s, int chr_delay);
+// add a string to the typewriter queue
+// The characters are printed with a delay of chr_delay milliseconds
+// by tb_display_typewriter_tick(). The string is copied.
+// With chr_delay = 0, the string is printed at once when it is
+// its turn (after the strings that are waiting).
+// returns false if the string does not fit into the queue
+// example:
+//    tb_display_type_String("The quick brown fox\n", 85);
+// =============================================================
+bool tb_display_type_String(const char *s, int chr_delay);
+
+// =============================================================
+//           tb_display_typewriter_tick();
+// print the next characters if they are due
+// call it as often as possible in the loop()
+// =============================================================
+void tb_display_typewriter_tick();
+
+// =============================================================
+//           tb_display_typewriter_pending();
+// returns the number of characters waiting to be typed
+// =============================================================
+int tb_display_typewriter_pending();
+
+// =============================================================
+//           tb_display_typewriter_flush();
+// print all waiting characters immediately
+// =============================================================
+void tb_display_typewriter_flush();
+
+// =============================================================
+//           tb_display_typewriter_clear();
+// remove all waiting characters without printing them
+// =============================================================
+void tb_display_typewriter_clear();
+
+#endif // TB_DISPLAY_TYPEWRITER_H
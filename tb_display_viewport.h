@@ -0,0 +1,235 @@
+/******************************************************************************
+ * tb_display_viewport.h
+ * Scrolling text areas (viewports) of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * A viewport is a rectangle on the screen that behaves like the text
+ * buffer display: new text is added at the bottom and the rows scroll
+ * up. The tb_display functions use one viewport that fills the screen.
+ * More viewports can share the screen with it, e.g. a small log area
+ * beside a status area.
+ *
+ * The class template TB_TextBuffer defines a viewport with the number
+ * of rows and characters per row, the position and the size on the
+ * screen at compile time. The memory of the text buffer is part of
+ * the object and has exactly the needed size. The drawing code is
+ * shared by all viewports (it is not duplicated for each size).
+ *
+ * example:
+ *    // 3 rows with 20 characters, at x=0, y=88, 135 pixel wide
+ *    TB_TextBuffer<3, 20, 0, 88, 135> log_area;
+ *    tb_display_init(2);
+ *    log_area.begin();
+ *    log_area.print_String("Hello\n");
+ *
+ * The hardware scroll, the row sprite mode and the scrollback history
+ * are only used by the viewport of the tb_display functions.
+ * Call tb_display_init() before the begin() of a viewport.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifndef TB_DISPLAY_VIEWPORT_H
+#define TB_DISPLAY_VIEWPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "tb_display_config.h"
+
+// the colors of a character:
+// foreground color in the low 4 bits, background color in the high 4 bits
+// (the ANSI color numbers 0 - 15, see tb_display_ansi)
+// default: white on black
+#define TB_ATTR_DEFAULT 0x0F
+// the cursor of the line editor: black on white
+#define TB_ATTR_CURSOR 0xF0
+
+// how a row of the text buffer ends
+// (a logical line is a row and all following wrapped rows)
+#define TB_ROW_END   0 // the line ends with a new line
+#define TB_ROW_WRAP  1 // the line continues in the next row
+#define TB_ROW_SPACE 2 // the line continues after a space that was
+                       // removed by the Word-Wrap
+
+// the state of a viewport
+// The arrays are provided by the owner of the viewport
+// (see TB_TextBuffer or tb_display_storage)
+typedef struct {
+  // position and size on the screen in pixel
+  int x;
+  int y;
+  int width;
+  int row_height;
+  // number of rows and maximum characters per row
+  // (the row length is also the size of the arrays)
+  int rows;
+  int line_length;
+  // the text buffer: rows * line_length characters
+  char *text;
+  // x position of each character of the text buffer in the viewport
+  // rows * (line_length+1)
+  // (the x position of the character behind the last one is the end of the row)
+  uint8_t *text_xpos;
+  // the changed part of each row of the text buffer:
+  // the first character position that needs a redraw
+  uint8_t *dirty_from;
+  // the colors of each character of the text buffer
+  // rows * line_length
+  uint8_t *attr;
+  // how each row of the text buffer ends (TB_ROW_END, ...)
+  uint8_t *row_end;
+  // what is shown on the screen, for each row of the display memory:
+  // the characters, their colors and the x position of each character
+  char *screen_text;
+  uint8_t *screen_attr;
+  uint8_t *screen_xpos;
+  uint8_t *screen_length;
+  // write position in the text buffer and the x position of the
+  // next character in the viewport
+  // The write position is in the last row, unless it is moved
+  // with an escape sequence.
+  int write_pointer_x;
+  int write_pointer_y;
+  int read_pointer_y;
+  int cursor_x;
+  // maximum x position of a character in the viewport
+  int max_x;
+  // hardware scroll of the LCD controller (only for the whole screen)
+  bool hw_scroll_active;
+  int hw_scroll_offset;
+  int hw_scroll_shown;
+  // the rows that scroll out of the viewport are added to the
+  // scrollback history
+  bool history;
+  // number of empty rows at the top that were never written
+  // (they are not added to the history when they scroll out)
+  int blank_rows;
+  // number of rows the viewport is scrolled back into the history
+  int scrollback_view;
+  // the text buffer is changed without drawing
+  bool batch;
+  // the colors of the next characters
+  uint8_t text_attr;
+  // the escape sequence parser:
+  // state, bold text, the numbers of the sequence
+  uint8_t ansi_state;
+  bool ansi_bold;
+  uint8_t ansi_count;
+  uint8_t ansi_params[4];
+  // the UTF-8 decoder: bytes missing for the character
+  // and the bits of the character received so far
+  uint8_t utf8_count;
+  uint32_t utf8_code;
+  // the text buffer has changed since the last refresh,
+  // the time of the first change and of the last frame
+  bool changed;
+  unsigned long changed_time;
+  unsigned long frame_last;
+} tb_display_viewport;
+
+// =============================================================
+// the functions of the tb_display API for a viewport
+// (see tb_display.h)
+// tb_display_viewport_begin() clears the text buffer and the
+// area of the viewport on the screen.
+// =============================================================
+void tb_display_viewport_begin(tb_display_viewport *vp);
+void tb_display_viewport_clear(tb_display_viewport *vp);
+void tb_display_viewport_show(tb_display_viewport *vp);
+void tb_display_viewport_refresh(tb_display_viewport *vp);
+bool tb_display_viewport_update(tb_display_viewport *vp);
+void tb_display_viewport_new_line(tb_display_viewport *vp);
+void tb_display_viewport_print_char(tb_display_viewport *vp, uint8_t data);
+void tb_display_viewport_print_String(tb_display_viewport *vp, const char *s, int chr_delay = 0);
+void tb_display_viewport_print_bytes(tb_display_viewport *vp, const uint8_t *data, size_t length);
+void tb_display_viewport_delete_char(tb_display_viewport *vp);
+
+// =============================================================
+// lay out several prints and draw the screen only once
+// Between begin and end, the print functions only change the
+// text buffer. tb_display_viewport_batch_end() draws the changes
+// (with a limited frame rate: the next tb_display_update()).
+// =============================================================
+void tb_display_viewport_batch_begin(tb_display_viewport *vp);
+void tb_display_viewport_batch_end(tb_display_viewport *vp);
+
+// =============================================================
+// the viewport of the tb_display functions (the whole screen)
+// e.g. to read the text buffer (see tb_display_mirror.h)
+// =============================================================
+tb_display_viewport *tb_display_screen_viewport();
+
+// =============================================================
+// the memory of a text buffer with ROWS rows of COLUMNS characters
+// =============================================================
+template<int ROWS, int COLUMNS>
+struct tb_display_storage {
+  // the dirty marker 0xFF and the x positions are stored in bytes
+  static_assert(ROWS > 0 && COLUMNS > 1 && COLUMNS < 255, "wrong text buffer size");
+  char text[ROWS][COLUMNS];
+  uint8_t text_xpos[ROWS][COLUMNS+1];
+  uint8_t dirty_from[ROWS];
+  uint8_t attr[ROWS][COLUMNS];
+  uint8_t row_end[ROWS];
+  char screen_text[ROWS][COLUMNS];
+  uint8_t screen_attr[ROWS][COLUMNS];
+  uint8_t screen_xpos[ROWS][COLUMNS+1];
+  uint8_t screen_length[ROWS];
+
+  // use this memory for the viewport
+  void attach(tb_display_viewport *vp){
+    vp->rows = ROWS;
+    vp->line_length = COLUMNS;
+    vp->text = &text[0][0];
+    vp->text_xpos = &text_xpos[0][0];
+    vp->dirty_from = dirty_from;
+    vp->attr = &attr[0][0];
+    vp->row_end = row_end;
+    vp->screen_text = &screen_text[0][0];
+    vp->screen_attr = &screen_attr[0][0];
+    vp->screen_xpos = &screen_xpos[0][0];
+    vp->screen_length = screen_length;
+  }
+};
+
+// =============================================================
+// a viewport with ROWS rows of COLUMNS characters (including the
+// null terminator) at the position X, Y on the screen
+// WIDTH = width of the viewport in pixel
+// ROW_HEIGHT = height of a row in pixel
+// =============================================================
+template<int ROWS, int COLUMNS, int X, int Y, int WIDTH, int ROW_HEIGHT = TEXT_HEIGHT>
+class TB_TextBuffer {
+  // the x positions in the viewport are stored in bytes
+  static_assert(WIDTH > 2 && WIDTH < 256, "wrong viewport width");
+  static_assert(ROW_HEIGHT >= TEXT_HEIGHT, "the rows are smaller than the font");
+public:
+  TB_TextBuffer(){
+    memory.attach(&vp);
+    vp.x = X;
+    vp.y = Y;
+    vp.width = WIDTH;
+    vp.row_height = ROW_HEIGHT;
+    vp.hw_scroll_active = false;
+    vp.history = false;
+    vp.batch = false;
+    vp.changed = false;
+    vp.frame_last = 0;
+  }
+  void begin(){ tb_display_viewport_begin(&vp); }
+  void clear(){ tb_display_viewport_clear(&vp); }
+  void show(){ tb_display_viewport_show(&vp); }
+  void refresh(){ tb_display_viewport_refresh(&vp); }
+  bool update(){ return tb_display_viewport_update(&vp); }
+  void new_line(){ tb_display_viewport_new_line(&vp); }
+  void print_char(uint8_t data){ tb_display_viewport_print_char(&vp, data); }
+  void print_String(const char *s, int chr_delay = 0){ tb_display_viewport_print_String(&vp, s, chr_delay); }
+  void print_bytes(const uint8_t *data, size_t length){ tb_display_viewport_print_bytes(&vp, data, length); }
+  void delete_char(){ tb_display_viewport_delete_char(&vp); }
+  tb_display_viewport *viewport(){ return &vp; }
+private:
+  tb_display_storage<ROWS, COLUMNS> memory;
+  tb_display_viewport vp;
+};
+
+#endif // TB_DISPLAY_VIEWPORT_H
@@ -0,0 +1,227 @@
+/******************************************************************************
+ * tb_history_check.cpp
+ * Linux host check of the scrollback history of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * The rows on the screen can still change after they are completed:
+ * an escape sequence moves the write position up and overwrites a row,
+ * a line that is edited wraps into a new row at the bottom and becomes
+ * shorter again. Each case writes text with such changes and compares
+ * the history rows and the screen scrolled back row by row with a
+ * reference that prints the final text directly. Then both print lines
+ * until the changed rows have scrolled out and are compared again.
+ * The exit code is 1 if a row of the history or a frame differs.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_history_check.cpp -o tb_history_check -lpthread
+ *    ./tb_history_check
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "tb_display_host.h"
+#include "tb_display.h"
+#include "tb_display_backend.h"
+#include "tb_display_scrollback.h"
+
+// lines printed in front of each case (more than the rows of the screen)
+#define HISTORY_CHECK_LINES 20
+
+// =============================================================
+// the history and the screen at each scroll position
+// =============================================================
+struct history_state {
+  std::vector<std::string> rows;
+  std::vector<uint8_t> row_ends;
+  std::vector<std::vector<uint16_t> > frames;
+};
+
+// the image on the screen (rotated by the hardware scroll offset)
+static std::vector<uint16_t> history_frame(){
+  const uint16_t *pixels = tb_display_framebuffer_pixels();
+  int width = tb_display_framebuffer_width();
+  int height = tb_display_framebuffer_height();
+  int offset = tb_display_framebuffer_scroll_offset();
+  std::vector<uint16_t> frame(width*height);
+  for(int y = 0; y < height; y++)
+    memcpy(&frame[y*width], &pixels[((y+offset) % height)*width], width*sizeof(uint16_t));
+  return frame;
+}
+
+static void history_capture(history_state *state){
+  state->rows.clear();
+  state->row_ends.clear();
+  state->frames.clear();
+  for(int n = 0; n < tb_display_scrollback_count(); n++){
+    state->rows.push_back(tb_display_scrollback_row(n));
+    state->row_ends.push_back(tb_display_scrollback_row_end(n));
+  }
+  for(int view = 0; view <= tb_display_scrollback_count(); view++){
+    tb_display_scroll_back(view - tb_display_scroll_position());
+    state->frames.push_back(history_frame());
+  }
+  tb_display_scroll_back(-tb_display_scroll_position());
+}
+
+// =============================================================
+// compare with the reference, print the first difference
+// =============================================================
+static bool history_compare(const char *name, const char *step,
+                            const history_state &state, const history_state &reference){
+  if(state.rows.size() != reference.rows.size()){
+    printf("%s, %s: %u history rows, reference %u\n", name, step,
+           (unsigned)state.rows.size(), (unsigned)reference.rows.size());
+    return false;
+  }
+  for(unsigned int n = 0; n < state.rows.size(); n++){
+    if(state.rows[n] != reference.rows[n] || state.row_ends[n] != reference.row_ends[n]){
+      printf("%s, %s: history row %u \"%s\", reference \"%s\"\n", name, step, n,
+             state.rows[n].c_str(), reference.rows[n].c_str());
+      return false;
+    }
+  }
+  for(unsigned int view = 0; view < state.frames.size(); view++){
+    if(state.frames[view] != reference.frames[view]){
+      printf("%s, %s: the screen scrolled back %u rows differs\n", name, step, view);
+      return false;
+    }
+  }
+  return true;
+}
+
+// =============================================================
+// an empty screen and history with numbered lines
+// =============================================================
+static void history_start(){
+  tb_display_clear();
+  tb_display_scrollback_clear();
+  char line[24];
+  for(int n = 1; n <= HISTORY_CHECK_LINES; n++){
+    snprintf(line, sizeof(line), "line %d\n", n);
+    tb_display_print_String(line);
+  }
+}
+
+static void history_fill(){
+  char line[24];
+  for(int n = 1; n <= HISTORY_CHECK_LINES; n++){
+    snprintf(line, sizeof(line), "fill %d\n", n);
+    tb_display_print_String(line);
+  }
+}
+
+// =============================================================
+// compare a case with the reference text, directly after the
+// case and after the rows have scrolled out
+// =============================================================
+static bool history_check(const char *name, void (*write_case)(), const std::string &final_text){
+  history_state state, reference;
+  bool ok = true;
+  history_start();
+  tb_display_print_String(final_text.c_str());
+  history_capture(&reference);
+  history_start();
+  write_case();
+  history_capture(&state);
+  ok = history_compare(name, "on the screen", state, reference) && ok;
+
+  history_start();
+  tb_display_print_String(final_text.c_str());
+  history_fill();
+  history_capture(&reference);
+  history_start();
+  write_case();
+  history_fill();
+  history_capture(&state);
+  ok = history_compare(name, "scrolled out", state, reference) && ok;
+  printf("%-22s %s\n", name, ok ? "ok" : "DIFFERS");
+  return ok;
+}
+
+// =============================================================
+// the cases
+// =============================================================
+
+// a completed row is overwritten with an escape sequence
+static void history_case_overwrite(){
+  tb_display_print_String("line 21\n\x1b[1ATEMP 99\x1b[K\n");
+}
+
+// the rows above the write position are overwritten
+static void history_case_rows_above(){
+  tb_display_print_String("line 21\nline 22\nline 23\n\x1b[3A\x1b[2KTEMP 1\n\x1b[2KTEMP 2\n\n");
+}
+
+// type the edited line until it wraps into a new row at the bottom
+static void history_edit_wrap(){
+  tb_display_edit_begin();
+  int count = tb_display_scrollback_count();
+  for(int n = 0; tb_display_scrollback_count() == count; n++)
+    tb_display_edit_key('a' + n % 26);
+  for(int n = 0; n < 5; n++)
+    tb_display_edit_key('0' + n);
+}
+
+// characters are inserted into the wrapped line
+static std::string history_edited_line;
+static void history_case_insert(){
+  history_edit_wrap();
+  for(int n = 0; n < 8; n++)
+    tb_display_edit_key(TB_KEY_LEFT);
+  tb_display_edit_key('X');
+  tb_display_edit_key('Y');
+  tb_display_edit_key('Z');
+  tb_display_edit_key('\n');
+  history_edited_line = tb_display_edit_line();
+}
+
+// characters are deleted in the wrapped line
+static void history_case_delete(){
+  history_edit_wrap();
+  for(int n = 0; n < 6; n++)
+    tb_display_edit_key(TB_KEY_LEFT);
+  tb_display_edit_key(127);
+  tb_display_edit_key(8);
+  tb_display_edit_key('\n');
+  history_edited_line = tb_display_edit_line();
+}
+
+// the wrapped line becomes one row again
+static void history_case_unwrap(){
+  history_edit_wrap();
+  for(int n = 0; n < 20; n++)
+    tb_display_edit_key(8);
+  tb_display_edit_key('\n');
+  history_edited_line = tb_display_edit_line();
+}
+
+// the final text of an editor case (the completed line)
+static std::string history_edited(void (*edit_case)()){
+  history_start();
+  edit_case();
+  return history_edited_line + "\n";
+}
+
+int main(){
+  tb_display_init(1);
+  tb_display_ansi = true;
+  bool ok = true;
+  for(int rotation = 1; rotation <= 2; rotation++){
+    tb_display_set_rotation(rotation);
+    printf("rotation %d\n", rotation);
+    ok = history_check("overwrite", history_case_overwrite, "TEMP 99\n") && ok;
+    ok = history_check("overwrite rows above", history_case_rows_above, "TEMP 1\nTEMP 2\nline 23\n") && ok;
+    ok = history_check("edit: insert", history_case_insert, history_edited(history_case_insert)) && ok;
+    ok = history_check("edit: delete", history_case_delete, history_edited(history_case_delete)) && ok;
+    ok = history_check("edit: unwrap", history_case_unwrap, history_edited(history_case_unwrap)) && ok;
+  }
+  printf("history: %s\n", ok ? "ok" : "DIFFERS");
+  return ok ? 0 : 1;
+}
+
+#endif // TB_DISPLAY_HOST
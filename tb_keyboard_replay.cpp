@@ -0,0 +1,178 @@
+/******************************************************************************
+ * tb_keyboard_replay.cpp
+ * Linux host test of the polling of the Keyboard-Hat.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Replays a typing script through a Wire stand-in that answers the
+ * reads of the Keyboard-Hat like the CardKB: it keeps only the last
+ * pressed key and returns it once. Each read blocks for the time of an
+ * I2C transaction. A loop like the loop() of main.cpp calls
+ * tb_display_keyboard_poll() and reads the keys from the queue.
+ * The script has an idle phase, a burst of typing and an idle phase
+ * again. For each phase, it reports the bus transactions per second,
+ * the poll interval at the end of the phase, the loop passes per second,
+ * the keys that were typed, read and lost, and the longest time from a
+ * key press to the read. The exit code is 1 if a typed key was lost.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_keyboard_replay.cpp -o tb_keyboard_replay -lpthread
+ *    ./tb_keyboard_replay [-k keys per second]
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tb_display_host.h"
+#include "tb_display_config.h"
+#include "tb_display_keyboard.h"
+
+// blocking time of one read of the Keyboard-Hat in microseconds
+// (address and one data byte at 100 kHz with the overhead of the driver)
+#define KEYBOARD_TRANSACTION_US 250
+// keys per second of the burst
+#define KEYBOARD_BURST_RATE 8
+
+// =============================================================
+// the typing script: phases with a duration and a typing rate
+// (0 keys per second = nobody is typing)
+// =============================================================
+typedef struct {
+  const char *name;
+  unsigned long duration_ms;
+  int keys_per_second;
+} keyboard_phase;
+
+static keyboard_phase keyboard_script[] = {
+  {"idle",  4000, 0},
+  {"burst", 3000, KEYBOARD_BURST_RATE},
+  {"idle",  4000, 0}
+};
+#define KEYBOARD_PHASES (sizeof(keyboard_script)/sizeof(keyboard_script[0]))
+
+static const char keyboard_text[] = "the quick brown fox jumps over the lazy dog ";
+
+// =============================================================
+// the I2C bus with a CardKB at TB_DISPLAY_CARDKB_ADDR
+// The keys of the script are pressed at their time. The CardKB
+// keeps only the last key, an unread key is lost by the next one.
+// =============================================================
+class ScriptWire {
+public:
+  void press(uint8_t key, unsigned long time_ms){
+    if(pending != 0)
+      lost++;
+    pending = key;
+    pressed_at = time_ms;
+  }
+  uint8_t requestFrom(int address, int quantity){
+    // the transaction blocks the caller
+    unsigned long start = micros();
+    while(micros() - start < KEYBOARD_TRANSACTION_US)
+      ;
+    received = 0;
+    if(address != TB_DISPLAY_CARDKB_ADDR || quantity < 1)
+      return 0;
+    data = pending;
+    received = 1;
+    if(pending != 0){
+      unsigned long latency = millis() - pressed_at;
+      if(latency > max_latency)
+        max_latency = latency;
+      pending = 0;
+    }
+    return received;
+  }
+  int available(){
+    return received;
+  }
+  int read(){
+    if(received == 0)
+      return -1;
+    received = 0;
+    return data;
+  }
+
+  uint32_t lost = 0;
+  unsigned long max_latency = 0;
+
+private:
+  uint8_t pending = 0;
+  unsigned long pressed_at = 0;
+  uint8_t data = 0;
+  int received = 0;
+};
+
+static ScriptWire Wire;
+
+// =============================================================
+// the reader of the Keyboard-Hat (as tb_display_keyboard_cardkb)
+// =============================================================
+static uint8_t replay_cardkb(){
+  uint8_t key = 0;
+  Wire.requestFrom(TB_DISPLAY_CARDKB_ADDR, 1);
+  while(Wire.available())
+    key = Wire.read();
+  return key;
+}
+
+int main(int argc, char *argv[]){
+  for(int n = 1; n < argc; n++){
+    if(strcmp(argv[n], "-k") == 0 && n+1 < argc){
+      keyboard_script[1].keys_per_second = atoi(argv[++n]);
+    } else {
+      fprintf(stderr, "usage: %s [-k keys per second]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  tb_display_keyboard_begin(replay_cardkb);
+  printf("transaction %u us, interval %u-%u ms\n", KEYBOARD_TRANSACTION_US,
+         TB_DISPLAY_KEYBOARD_FAST_MS, TB_DISPLAY_KEYBOARD_SLOW_MS);
+  printf("%-6s %8s %14s %9s %7s %6s %6s %11s\n", "phase", "time", "transactions/s",
+         "interval", "loops/s", "typed", "read", "latency max");
+  bool ok = true;
+  int text_pos = 0;
+  for(unsigned int p = 0; p < KEYBOARD_PHASES; p++){
+    const keyboard_phase *phase = &keyboard_script[p];
+    uint32_t transactions = tb_display_keyboard_transactions();
+    uint32_t lost = Wire.lost;
+    Wire.max_latency = 0;
+    uint32_t loops = 0;
+    int typed = 0;
+    int read = 0;
+    unsigned long start = millis();
+    unsigned long now = start;
+    while(now - start < phase->duration_ms){
+      // the keys of the script that are due
+      while(phase->keys_per_second > 0 &&
+            (unsigned long)typed * 1000 / phase->keys_per_second <= now - start){
+        Wire.press(keyboard_text[text_pos], now);
+        text_pos = (text_pos + 1) % (sizeof(keyboard_text) - 1);
+        typed++;
+      }
+      // the loop() of main.cpp
+      tb_display_keyboard_poll();
+      while(tb_display_keyboard_read() >= 0)
+        read++;
+      loops++;
+      now = millis();
+    }
+    unsigned long duration = now - start;
+    transactions = tb_display_keyboard_transactions() - transactions;
+    lost = Wire.lost - lost;
+    printf("%-6s %6lums %14lu %7lums %7lu %6d %6d %9lums\n", phase->name, duration,
+           (unsigned long)transactions * 1000 / duration, tb_display_keyboard_interval(),
+           (unsigned long)loops * 1000 / duration, typed, read, Wire.max_latency);
+    if(lost > 0){
+      printf("%-6s %u keys lost\n", phase->name, lost);
+      ok = false;
+    }
+  }
+  printf("keys: %s\n", ok ? "ok" : "LOST");
+  return ok ? 0 : 1;
+}
+
+#endif // TB_DISPLAY_HOST
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * tb_mirror_view.cpp
+ * Linux viewer of the text buffer display mirror.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Reads the frames of tb_display_mirror_update() from the serial port
+ * of the M5Stick (or from stdin) and shows the rows of the screen in
+ * the terminal. Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_mirror_view.cpp -o tb_mirror_view
+ *    ./tb_mirror_view /dev/ttyUSB0
+ * The text of the Serial.print() calls between the frames is skipped.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "tb_display_mirror.h"
+
+// the speed of the serial port (see Serial.begin in main.cpp)
+#define MIRROR_VIEW_BAUD B115200
+
+static tb_display_mirror_decoder decoder;
+
+// =============================================================
+// raw mode of the serial port
+// =============================================================
+static void mirror_view_setup(int fd){
+  struct termios tty;
+  if(tcgetattr(fd, &tty) != 0)
+    return; // not a serial port (e.g. a file)
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, MIRROR_VIEW_BAUD);
+  cfsetospeed(&tty, MIRROR_VIEW_BAUD);
+  tty.c_cc[VMIN] = 1;
+  tty.c_cc[VTIME] = 0;
+  tcsetattr(fd, TCSANOW, &tty);
+}
+
+// =============================================================
+// show the rows of the screen
+// =============================================================
+static void mirror_view_show(){
+  // cursor home and clear the terminal
+  printf("\033[H\033[2J");
+  for(int n = 0; n < decoder.rows; n++)
+    printf("|%s\n", tb_display_mirror_row(&decoder, n));
+  printf("frames: %u  errors: %u  lost: %u%s\n",
+         (unsigned)decoder.frames, (unsigned)decoder.errors, (unsigned)decoder.lost,
+         decoder.synced ? "" : "  (waiting for a key frame)");
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]){
+  int fd = 0;
+  if(argc > 1){
+    fd = open(argv[1], O_RDONLY | O_NOCTTY);
+    if(fd < 0){
+      perror(argv[1]);
+      return 1;
+    }
+    mirror_view_setup(fd);
+  }
+  tb_display_mirror_decoder_init(&decoder);
+  uint8_t buffer[256];
+  ssize_t length;
+  while((length = read(fd, buffer, sizeof(buffer))) > 0){
+    bool changed = false;
+    for(ssize_t n = 0; n < length; n++)
+      if(tb_display_mirror_decode(&decoder, buffer[n]))
+        changed = true;
+    if(changed)
+      mirror_view_show();
+  }
+  return 0;
+}
+
+#endif // TB_DISPLAY_HOST
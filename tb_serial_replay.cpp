@@ -0,0 +1,216 @@
+/******************************************************************************
+ * tb_serial_replay.cpp
+ * Linux host throughput test of the serial input of the display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Replays a captured log through a Stream stand-in that delivers the
+ * bytes with the speed of a serial port (8N1, 10 bits per byte) into
+ * a receive buffer of SERIAL_RX_BYTES like the UART driver. A loop
+ * like the loop() of main.cpp reads the available bytes in blocks,
+ * pushes them into the queue (tb_display_queue_push_bytes) and echoes
+ * them, while the render task prints them with 25 frames per second.
+ * For each baud rate from 115200 to 2000000, it reports the bytes
+ * lost in the receive buffer (the loop was too slow), the characters
+ * dropped by the full queue (the render task was too slow) and the
+ * sustained characters per second until the queue is empty.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_serial_replay.cpp -o tb_serial_replay -lpthread
+ *    ./tb_serial_replay [-d milliseconds] [log files]
+ * Without a log file, a generated log of short and long lines is
+ * replayed. The log is repeated for 2 seconds (-d) per baud rate.
+ * The framebuffer of the host is faster than the LCD of the M5Stick,
+ * so the numbers of the host are an upper limit.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "tb_display_host.h"
+#include "tb_display.h"
+#include "tb_display_queue.h"
+
+// receive buffer of the serial port (Serial.setRxBufferSize)
+#define SERIAL_RX_BYTES 256
+// characters read from the serial port at once (as in main.cpp)
+#define SERIAL_CHUNK 256
+// replay time per baud rate in milliseconds
+#define REPLAY_DURATION 2000
+
+static const unsigned long replay_bauds[] = {
+  115200, 230400, 460800, 921600, 1500000, 2000000
+};
+#define REPLAY_BAUDS (sizeof(replay_bauds)/sizeof(replay_bauds[0]))
+
+// =============================================================
+// a serial port that receives a log with the speed of a baud rate
+// The bytes arrive in real time. Bytes that arrive while the
+// receive buffer is full are lost, as in the UART driver.
+// =============================================================
+class ReplayStream : public Stream {
+public:
+  ReplayStream(const std::vector<uint8_t> &log, unsigned long baud, unsigned long duration_ms)
+    : log(log), bytes_per_second(baud/10),
+      total((uint64_t)baud/10*duration_ms/1000), start(micros()) {}
+
+  int available(){
+    receive();
+    return buffered;
+  }
+  int read(){
+    if(available() == 0)
+      return -1;
+    buffered--;
+    return log[read_pos++ % log.size()];
+  }
+  int peek(){
+    if(available() == 0)
+      return -1;
+    return log[read_pos % log.size()];
+  }
+  // the echo is only counted
+  size_t write(uint8_t){
+    echoed++;
+    return 1;
+  }
+  size_t write(const uint8_t *, size_t size){
+    echoed += size;
+    return size;
+  }
+  using Print::write;
+
+  // all bytes of the replay have arrived and are read
+  bool finished(){
+    return available() == 0 && arrived == total;
+  }
+
+  uint64_t arrived = 0;
+  uint64_t lost = 0;
+  uint64_t echoed = 0;
+
+private:
+  const std::vector<uint8_t> &log;
+  uint64_t bytes_per_second;
+  uint64_t total;
+  unsigned long start;
+  uint64_t read_pos = 0;
+  int buffered = 0;
+
+  // the bytes that arrived since the last call
+  void receive(){
+    uint64_t now = (uint64_t)(micros() - start) * bytes_per_second / 1000000;
+    if(now > total)
+      now = total;
+    uint64_t new_bytes = now - arrived;
+    arrived = now;
+    uint64_t space = SERIAL_RX_BYTES - buffered;
+    if(new_bytes > space){
+      lost += new_bytes - space;
+      // the lost bytes are skipped in the log
+      read_pos += new_bytes - space;
+      new_bytes = space;
+    }
+    buffered += new_bytes;
+  }
+};
+
+// =============================================================
+// the serial input of the loop() in main.cpp
+// =============================================================
+static void replay_loop(Stream &serial){
+  while(serial.available() > 0){
+    uint8_t buffer[SERIAL_CHUNK];
+    int length = serial.available();
+    if(length > SERIAL_CHUNK)
+      length = SERIAL_CHUNK;
+    length = serial.readBytes(buffer, length);
+    tb_display_queue_push_bytes(buffer, length);
+    serial.write(buffer, length);
+  }
+}
+
+// =============================================================
+// a log of short status lines and long lines
+// =============================================================
+static void replay_generate(std::vector<uint8_t> &log){
+  char line[128];
+  uint32_t random = 1;
+  for(int n = 0; n < 2000; n++){
+    random = random*1103515245 + 12345;
+    int length;
+    if(n % 10 == 9)
+      length = snprintf(line, sizeof(line), "[%6u.%03u] wifi: scan done, %u networks found, strongest rssi -%u dBm on channel %u\n",
+                        n/10, n%1000, (random >> 16) % 20, 30 + (random >> 8) % 60, 1 + (random >> 4) % 13);
+    else
+      length = snprintf(line, sizeof(line), "t=%u adc=%u\n", n, (random >> 16) % 4096);
+    log.insert(log.end(), line, line + length);
+  }
+}
+
+static bool replay_read_file(std::vector<uint8_t> &log, const char *file_name){
+  FILE *file = fopen(file_name, "rb");
+  if(file == NULL)
+    return false;
+  uint8_t buffer[4096];
+  size_t length;
+  while((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    log.insert(log.end(), buffer, buffer + length);
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char *argv[]){
+  unsigned long duration = REPLAY_DURATION;
+  std::vector<uint8_t> log;
+  for(int n = 1; n < argc; n++){
+    if(strcmp(argv[n], "-d") == 0 && n+1 < argc){
+      duration = strtoul(argv[++n], NULL, 10);
+    } else if(!replay_read_file(log, argv[n])){
+      fprintf(stderr, "usage: %s [-d milliseconds] [log files]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(log.empty())
+    replay_generate(log);
+
+  tb_display_init(1);
+  tb_display_set_frame_rate(25);
+  tb_display_render_task_begin();
+  printf("log: %u bytes, %lu ms per baud rate\n", (unsigned)log.size(), duration);
+  printf("%8s %10s %10s %8s %8s %12s\n", "baud", "offered/s", "received", "lost", "dropped", "displayed/s");
+  // the highest baud rate without lost characters at all lower rates
+  unsigned long best = 0;
+  bool clean = true;
+  for(unsigned int b = 0; b < REPLAY_BAUDS; b++){
+    uint32_t dropped = tb_display_queue_dropped();
+    ReplayStream serial(log, replay_bauds[b], duration);
+    unsigned long start = micros();
+    while(!serial.finished())
+      replay_loop(serial);
+    // until the render task has printed all characters
+    while(tb_display_queue_fill() > 0)
+      delay(1);
+    unsigned long time_us = micros() - start;
+    dropped = tb_display_queue_dropped() - dropped;
+    uint64_t displayed = serial.arrived - serial.lost - dropped;
+    printf("%8lu %10lu %10llu %8llu %8u %12llu\n", replay_bauds[b], replay_bauds[b]/10,
+           (unsigned long long)serial.arrived, (unsigned long long)serial.lost, dropped,
+           (unsigned long long)(displayed * 1000000 / time_us));
+    if(serial.lost > 0 || dropped > 0)
+      clean = false;
+    else if(clean)
+      best = replay_bauds[b];
+  }
+  tb_display_render_task_end();
+  if(best > 0)
+    printf("without lost characters up to %lu baud\n", best);
+  else
+    printf("characters lost at %lu baud\n", replay_bauds[0]);
+  return 0;
+}
+
+#endif // TB_DISPLAY_HOST
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * tb_snapshot_check.cpp
+ * Linux host check of the snapshot of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * Simulates the deep sleep with tb_display_snapshot_memory() and
+ * tb_display_snapshot_wake_up() and checks:
+ *   - tb_display_snapshot_save() and tb_display_init() after the wake
+ *     up show the same frame as before the snapshot
+ *   - a snapshot with one changed bit is not valid and the screen is
+ *     empty after the wake up
+ *   - a snapshot of another number of rows (status rows) or another
+ *     row length (orientation) is not used
+ *   - a tb_display_init() that is not the first one after the start
+ *     clears the screen and keeps the snapshot
+ * The exit code is 1 if a check fails.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_snapshot_check.cpp -o tb_snapshot_check -lpthread
+ *    ./tb_snapshot_check
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "tb_display_host.h"
+#include "tb_display.h"
+#include "tb_display_backend.h"
+#include "tb_display_snapshot.h"
+
+// the header in front of the rows (see tb_display_snapshot.cpp)
+#define SNAPSHOT_CHECK_HEADER 14
+
+// =============================================================
+// the image on the screen (rotated by the hardware scroll offset)
+// =============================================================
+static std::vector<uint16_t> snapshot_frame(){
+  const uint16_t *pixels = tb_display_framebuffer_pixels();
+  int width = tb_display_framebuffer_width();
+  int height = tb_display_framebuffer_height();
+  int offset = tb_display_framebuffer_scroll_offset();
+  std::vector<uint16_t> frame(width*height);
+  for(int y = 0; y < height; y++)
+    memcpy(&frame[y*width], &pixels[((y+offset) % height)*width], width*sizeof(uint16_t));
+  return frame;
+}
+
+// the frame of an empty screen after the start
+static std::vector<uint16_t> snapshot_empty_frame(int rotation){
+  tb_display_snapshot_discard();
+  tb_display_snapshot_wake_up();
+  tb_display_init(rotation);
+  return snapshot_frame();
+}
+
+// =============================================================
+// rows with colors, wrapped rows and the write position inside
+// of a row
+// =============================================================
+static void snapshot_print_text(){
+  tb_display_print_String("M5StickC\n\x1b[31mred\x1b[0m and \x1b[1;32mgreen\x1b[0m\n");
+  for(int n = 0; n < 12; n++){
+    char line[64];
+    snprintf(line, sizeof(line), "row %d of the text before the deep sleep\n", n);
+    tb_display_print_String(line);
+  }
+  tb_display_print_String("prompt> abc\x1b[2D");
+}
+
+static bool snapshot_report(const char *name, bool ok){
+  printf("%-34s %s\n", name, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// =============================================================
+// the snapshot shows the frame from before the deep sleep
+// =============================================================
+static bool snapshot_check_restore(int rotation){
+  tb_display_snapshot_wake_up();
+  tb_display_init(rotation);
+  snapshot_print_text();
+  tb_display_show();
+  std::vector<uint16_t> before = snapshot_frame();
+  if(!tb_display_snapshot_save())
+    return false;
+  tb_display_print_String("\nlost in the deep sleep\n");
+  tb_display_snapshot_wake_up();
+  tb_display_init(rotation);
+  return snapshot_frame() == before && !tb_display_snapshot_valid();
+}
+
+// =============================================================
+// every changed bit of the snapshot is found
+// =============================================================
+static bool snapshot_check_damaged(int rotation){
+  std::vector<uint16_t> empty = snapshot_empty_frame(rotation);
+  snapshot_print_text();
+  if(!tb_display_snapshot_save())
+    return false;
+  uint8_t *memory = tb_display_snapshot_memory();
+  // the header and the rows up to the end of the snapshot
+  int length = SNAPSHOT_CHECK_HEADER + (memory[8] | (memory[9] << 8));
+  for(int n = 0; n < length; n++){
+    memory[n] ^= 1 << (n % 8);
+    bool valid = tb_display_snapshot_valid();
+    memory[n] ^= 1 << (n % 8);
+    if(valid){
+      printf("byte %d changed: valid\n", n);
+      return false;
+    }
+  }
+  // a damaged row is not shown
+  memory[length/2] ^= 0x10;
+  tb_display_snapshot_wake_up();
+  tb_display_init(rotation);
+  return snapshot_frame() == empty;
+}
+
+// =============================================================
+// a snapshot of another size of the text buffer is not used
+// =============================================================
+static bool snapshot_check_size(int rotation, int other_rotation, int other_status_rows){
+  std::vector<uint16_t> empty;
+  tb_display_status_rows = other_status_rows;
+  empty = snapshot_empty_frame(other_rotation);
+  tb_display_status_rows = 0;
+  tb_display_snapshot_wake_up();
+  tb_display_init(rotation);
+  snapshot_print_text();
+  if(!tb_display_snapshot_save())
+    return false;
+  tb_display_status_rows = other_status_rows;
+  tb_display_snapshot_wake_up();
+  tb_display_init(other_rotation);
+  bool ok = snapshot_frame() == empty;
+  tb_display_status_rows = 0;
+  return ok;
+}
+
+// =============================================================
+// only the first tb_display_init() after the start restores
+// =============================================================
+static bool snapshot_check_later_init(int rotation){
+  std::vector<uint16_t> empty = snapshot_empty_frame(rotation);
+  snapshot_print_text();
+  if(!tb_display_snapshot_save())
+    return false;
+  tb_display_init(rotation);
+  return snapshot_frame() == empty && tb_display_snapshot_valid();
+}
+
+int main(){
+  tb_display_ansi = true;
+  bool ok = true;
+  for(int rotation = 1; rotation <= 2; rotation++){
+    int other_rotation = rotation == 1 ? 2 : 1;
+    printf("rotation %d\n", rotation);
+    ok = snapshot_report("save, init: same frame", snapshot_check_restore(rotation)) && ok;
+    ok = snapshot_report("changed bit: rejected", snapshot_check_damaged(rotation)) && ok;
+    ok = snapshot_report("other rows: rejected", snapshot_check_size(rotation, rotation, 1)) && ok;
+    ok = snapshot_report("other orientation: rejected", snapshot_check_size(rotation, other_rotation, 0)) && ok;
+    ok = snapshot_report("later init: kept, not restored", snapshot_check_later_init(rotation)) && ok;
+  }
+  printf("snapshot: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
+
+#endif // TB_DISPLAY_HOST
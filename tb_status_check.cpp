@@ -0,0 +1,113 @@
+/******************************************************************************
+ * tb_status_check.cpp
+ * Linux host check of the status fields of the text buffer display.
+ * Hague Nusseck @ electricidea
+ * https://github.com/electricidea/M5StickC-TB_Display
+ *
+ * A status field shows the characters that fit into a row of the
+ * scrolling text with the same width. For each character of a value,
+ * the width of a field is chosen so that this character ends exactly
+ * at the right edge of the field. Like in a row of the scrolling text,
+ * the character does not fit anymore: the field must show the same
+ * frame as the value without it. The same is checked for fields that
+ * are one pixel wider, where the character fits.
+ * The exit code is 1 if a field shows other characters.
+ * Only compiled with the build flag TB_DISPLAY_HOST:
+ *    g++ -O2 -D TB_DISPLAY_HOST -I. tb_display*.cpp tb_status_check.cpp -o tb_status_check -lpthread
+ *    ./tb_status_check
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#ifdef TB_DISPLAY_HOST
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "tb_display_host.h"
+#include "tb_display.h"
+#include "tb_display_backend.h"
+
+// the space in front of the first character and behind the last one
+// (SCREEN_XSTARTPOS and SCREEN_XMARGIN of tb_display.cpp)
+#define STATUS_CHECK_XSTARTPOS 5
+#define STATUS_CHECK_XMARGIN 2
+
+// =============================================================
+// the status row of the screen
+// =============================================================
+static std::vector<uint16_t> status_frame(){
+  const uint16_t *pixels = tb_display_framebuffer_pixels();
+  int width = tb_display_framebuffer_width();
+  return std::vector<uint16_t>(pixels, pixels + width*TEXT_HEIGHT);
+}
+
+// the width of a character as used by the library
+static int status_char_width(uint8_t data){
+  const tb_display_backend *backend = tb_display_get_backend();
+  if(backend->glyph_widths != NULL)
+    return backend->glyph_widths[data-32];
+  return backend->char_width(data, TEXT_SIZE);
+}
+
+// =============================================================
+// the frame of a new field with a value
+// =============================================================
+static std::vector<uint16_t> status_show(int width, const std::string &value){
+  tb_display_status_field(0, 0, 0, width);
+  tb_display_status_set(0, value.c_str());
+  return status_frame();
+}
+
+// =============================================================
+// the field ends exactly behind the character "length-1" of the
+// value, or one pixel later
+// =============================================================
+static bool status_check_edge(const std::string &value, int length, int extra){
+  int xpos = STATUS_CHECK_XSTARTPOS;
+  for(int n = 0; n < length; n++)
+    xpos += status_char_width(value[n]);
+  int width = xpos + STATUS_CHECK_XMARGIN + extra;
+  if(width > 255 || width > tb_display_framebuffer_width())
+    return true;
+  // like tb_display_layout_char: the character fits only if it ends
+  // left of the margin
+  int visible = extra > 0 ? length : length-1;
+  std::vector<uint16_t> frame = status_show(width, value);
+  std::vector<uint16_t> expected = status_show(width, value.substr(0, visible));
+  if(frame != expected){
+    printf("width %d: \"%s\" shows other characters than \"%s\"\n", width,
+           value.c_str(), value.substr(0, visible).c_str());
+    return false;
+  }
+  return true;
+}
+
+int main(){
+  static const char *values[] = {
+    "T=23.5C", "1234567890", "WiFi -67 dBm", "mmmmWWWW", "il1.,;:!|"
+  };
+  tb_display_set_backend(&tb_display_backend_framebuffer);
+  tb_display_status_rows = 1;
+  bool ok = true;
+  for(int rotation = 1; rotation <= 2; rotation++){
+    tb_display_init(rotation);
+    int checks = 0;
+    bool rotation_ok = true;
+    for(unsigned int v = 0; v < sizeof(values)/sizeof(values[0]); v++){
+      std::string value = values[v];
+      for(int length = 1; length <= (int)value.size(); length++){
+        rotation_ok = status_check_edge(value, length, 0) && rotation_ok;
+        rotation_ok = status_check_edge(value, length, 1) && rotation_ok;
+        checks += 2;
+      }
+    }
+    printf("rotation %d: %d field widths %s\n", rotation, checks, rotation_ok ? "ok" : "DIFFER");
+    ok = ok && rotation_ok;
+  }
+  tb_display_status_rows = 0;
+  printf("status fields: %s\n", ok ? "ok" : "DIFFER");
+  return ok ? 0 : 1;
+}
+
+#endif // TB_DISPLAY_HOST